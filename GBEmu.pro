@@ -8,6 +8,26 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+CONFIG   += c++11
+
+# "qmake CONFIG+=threaded_core" makes cpu::run_for() use the threaded interpreter core
+# (cpu::run_threaded) instead of the opcode handlers table
+threaded_core: DEFINES += GB_THREADED_CORE
+# "qmake CONFIG+=no_computed_goto" makes the threaded core dispatch with a switch
+no_computed_goto: DEFINES += GB_NO_COMPUTED_GOTO
+# "qmake CONFIG+=lazy_flags" makes the 8-bit ALU opcodes defer flags computation
+# until F is read
+lazy_flags: DEFINES += GB_LAZY_FLAGS
+# "qmake CONFIG+=block_cache" makes cpu::run_for() execute cached pre-decoded blocks
+# (cpu::run_block), ignored if threaded_core is set
+block_cache: DEFINES += GB_BLOCK_CACHE
+# "qmake CONFIG+=jit" makes cpu::run_for() compile hot blocks to x86-64 code (gb::jit),
+# ignored if threaded_core or block_cache is set
+jit: DEFINES += GB_JIT
+# "qmake CONFIG+=jit_compare" (with jit) runs every block with the interpreter as well and stops
+# on the first difference (see jit::set_compare_mode())
+jit_compare: DEFINES += GB_JIT_COMPARE
+
 TARGET = GBEmu
 TEMPLATE = app
 
@@ -15,11 +35,13 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     gb/cpu.cpp \
-    gb/mmu.cpp
+    gb/mmu.cpp \
+    gb/jit.cpp
 
 HEADERS  += mainwindow.h \
     gb/cpu.h \
-    gb/mmu.h
+    gb/mmu.h \
+    gb/jit.h
 
 FORMS    += mainwindow.ui
 
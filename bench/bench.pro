@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Benchmark of the interpreter cores : the opcode handlers
+# (cpu::step_instruction) against the threaded core (cpu::run_threaded)
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+# same switches as GBEmu.pro, see there
+no_computed_goto: DEFINES += GB_NO_COMPUTED_GOTO
+lazy_flags: DEFINES += GB_LAZY_FLAGS
+
+TARGET = GBEmuBench
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    ../gb/cpu.cpp \
+    ../gb/mmu.cpp
+
+HEADERS  += ../gb/cpu.h \
+    ../gb/mmu.h
+
+INCLUDEPATH +=  C:/Users/Renaud/Documents/programmation/C++/CMake/MMO/SRC/Lib/Utils
+
+LIBS += C:/Users/Renaud/Documents/programmation/C++/CMake/MMO/lib/Debug/UTILS_lib.lib
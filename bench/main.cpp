@@ -0,0 +1,118 @@
+#include "../gb/cpu.h"
+#include "../gb/mmu.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+
+#include <iostream>
+
+using namespace gb;
+
+/* Loads, 8-bit ALU and a store to wram, looping from the entry point of the rom : the opcodes
+ * the threaded core inlines, and a 0xCB opcode and a jump going through the handlers as the
+ * other ones do.
+ */
+static const quint8 program[] =
+{
+    0x21, 0x00, 0xD0,       // 0x0100 LD HL, 0xD000
+    0x06, 0x10,             // 0x0103 LD B, 0x10
+    0x0E, 0x20,             // 0x0105 LD C, 0x20
+    0x78,                   // 0x0107 LD A, B
+    0x81,                   // 0x0108 ADD A, C
+    0x47,                   // 0x0109 LD B, A
+    0xA9,                   // 0x010A XOR C
+    0x4F,                   // 0x010B LD C, A
+    0x3C,                   // 0x010C INC A
+    0xCB, 0x37,             // 0x010D SWAP A
+    0xB0,                   // 0x010F OR B
+    0x57,                   // 0x0110 LD D, A
+    0x91,                   // 0x0111 SUB C
+    0x5F,                   // 0x0112 LD E, A
+    0x77,                   // 0x0113 LD (HL), A
+    0x7E,                   // 0x0114 LD A, (HL)
+    0x83,                   // 0x0115 ADD A, E
+    0xC3, 0x07, 0x01        // 0x0116 JP 0x0107
+};
+
+enum BENCH
+{
+    PROGRAM_START = 0x0100,     // where fast_boot() leaves PC
+    CARTRIDGE_SIZE = 0x8000,    // two banks, rom only
+    BENCH_CYCLES = 200000000,   // about 48 seconds of emulated time
+    BENCH_RUNS = 5              // the best run is kept
+};
+
+static quint32 run_handlers(cpu* c)
+{
+    quint32 elapsed = 0;
+
+    while(elapsed < BENCH_CYCLES)
+        elapsed += c->step_instruction();
+
+    return elapsed;
+}
+
+static quint32 run_threaded(cpu* c)
+{
+    return c->run_threaded(BENCH_CYCLES);
+}
+
+/* Best time of the runs in milliseconds, the cpu starting over from the program each time */
+static qint64 measure(cpu* c, quint32 (*run)(cpu*), quint32* cycles)
+{
+    qint64 best = -1;
+
+    for(quint8 i = 0 ; i < BENCH_RUNS ; ++i)
+    {
+        c->fast_boot(mmu::MODEL_DMG);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        *cycles = run(c);
+
+        qint64 time = timer.elapsed();
+
+        if(best < 0 || time < best) best = time;
+    }
+
+    return best;
+}
+
+static void report(const char* name, qint64 time, quint32 cycles, qint64 reference)
+{
+    std::cout << name << " : " << time << " ms, "
+              << (time ? cycles / 1000 / time : 0) << " Mcycles/s";
+
+    if(reference && time) std::cout << ", " << (double) reference / time << "x";
+
+    std::cout << std::endl;
+}
+
+int main()
+{
+    //the program is run as a cartridge
+    QByteArray rom(CARTRIDGE_SIZE, 0);
+    QTemporaryFile file;
+
+    rom.replace(PROGRAM_START, sizeof(program), (const char*) program, sizeof(program));
+
+    if(!file.open() || file.write(rom) != rom.size() || !file.flush())
+    {
+        std::cerr << "BENCH : cannot write the rom" << std::endl;
+        return 1;
+    }
+
+    if(!_MMU->load_cartridge(file.fileName())) return 1;
+
+    cpu* c = cpu::getInstance();
+
+    quint32 handlers_cycles, threaded_cycles;
+    qint64 handlers = measure(c, run_handlers, &handlers_cycles);
+    qint64 threaded = measure(c, run_threaded, &threaded_cycles);
+
+    report("handlers", handlers, handlers_cycles, 0);
+    report("threaded", threaded, threaded_cycles, handlers);
+
+    return 0;
+}
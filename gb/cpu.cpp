@@ -1,45 +1,717 @@
 #include "cpu.h"
 #include "mmu.h"
-
-#define _A (R[REGISTER_A])
-#define _B (R[REGISTER_B])
-#define _C (R[REGISTER_C])
-#define _D (R[REGISTER_D])
-#define _E (R[REGISTER_E])
-#define _H (R[REGISTER_H])
-#define _L (R[REGISTER_L])
-
-#define _BC ( (quint16)(_C + (_B << 8)) )
-#define _DE ( (quint16)(_E + (_D << 8)) )
-#define _HL ( (quint16)(_L + (_H << 8)) )
-
-#define _d8 ( (quint8) _MMU->rb(PC+1) )
-#define _d16 ( (quint16)( _MMU->rb(PC+1) + (_MMU->rb(PC+2) << 8) ) )
-#define _a8 ( (quint8) _MMU->rb(PC+1) )
-#define _a16 ( (quint16)( _MMU->rb(PC+1) + (_MMU->rb(PC+2) << 8) ) )
-#define _r8 ( (qint8) _MMU->rb(PC+1) )
+#include "jit.h"
+
+#define _A (AF.bytes.high)
+#define _F (AF.bytes.low)
+#define _B (BC.bytes.high)
+#define _C (BC.bytes.low)
+#define _D (DE.bytes.high)
+#define _E (DE.bytes.low)
+#define _H (HL.bytes.high)
+#define _L (HL.bytes.low)
+
+#define _AF (AF.word)
+#define _BC (BC.word)
+#define _DE (DE.word)
+#define _HL (HL.word)
+
+#define _d8 ( (quint8) operand )
+#define _d16 ( (quint16) operand )
+#define _a8 ( (quint8) operand )
+#define _a16 ( (quint16) operand )
+#define _r8 ( (qint8) operand )
 
 using namespace gb;
 
-cpu::opcode::opcode(QString mnemonic, quint8 length, quint8 cycles, opcode_func exec, quint8 not_exec_cycles)
-{
-    this->mnemonic = mnemonic;
-    this->length = length;
-    this->cycles = cycles;
-    this->exec = exec;
-    this->not_exec_cycles = not_exec_cycles;
+//1-byte opcodes
+constexpr cpu::opcode cpu::opcodes_table[256] =
+{
+    opcode(1, 4, &cpu::nop),                                        /* 0x00 - NOP */
+    opcode(3, 12, &cpu::ld_bc_d16),                                 /* 0x01 - LD BC, d16 */
+    opcode(1, 8, &cpu::ld_bc_a),                                    /* 0x02 - LD (BC), A */
+    opcode(1, 8, &cpu::inc_bc),                                     /* 0x03 - INC BC */
+    opcode(1, 4, &cpu::inc_b),                                      /* 0x04 - INC B */
+    opcode(1, 4, &cpu::dec_b),                                      /* 0x05 - DEC B */
+    opcode(2, 8, &cpu::ld_b_d8),                                    /* 0x06 - LD B, d8 */
+    opcode(1, 4, &cpu::rlca),                                       /* 0x07 - RLCA */
+    opcode(3, 20, &cpu::ld_a16_sp),                                 /* 0x08 - LD (a16), SP */
+    opcode(1, 8, &cpu::add_hl_bc),                                  /* 0x09 - ADD HL, BC */
+    opcode(1, 8, &cpu::ld_a_bc),                                    /* 0x0A - LD A, (BC) */
+    opcode(1, 8, &cpu::dec_bc),                                     /* 0x0B - DEC BC */
+    opcode(1, 4, &cpu::inc_c),                                      /* 0x0C - INC C */
+    opcode(1, 4, &cpu::dec_c),                                      /* 0x0D - DEC C */
+    opcode(2, 8, &cpu::ld_c_d8),                                    /* 0x0E - LD C, d8 */
+    opcode(1, 4, &cpu::rrca),                                       /* 0x0F - RRCA */
+
+    opcode(2, 4, &cpu::stop),                                       /* 0x10 - STOP 0 */
+    opcode(3, 12, &cpu::ld_de_d16),                                 /* 0x11 - LD DE, d16 */
+    opcode(1, 8, &cpu::ld_de_a),                                    /* 0x12 - LD (DE), A */
+    opcode(1, 8, &cpu::inc_de),                                     /* 0x13 - INC DE */
+    opcode(1, 4, &cpu::inc_d),                                      /* 0x14 - INC D */
+    opcode(1, 4, &cpu::dec_d),                                      /* 0x15 - DEC D */
+    opcode(2, 8, &cpu::ld_d_d8),                                    /* 0x16 - LD D, d8 */
+    opcode(1, 4, &cpu::rla),                                        /* 0x17 - RLA */
+    opcode(2, 12, &cpu::jr_r8),                                     /* 0x18 - JR r8 */
+    opcode(1, 8, &cpu::add_hl_de),                                  /* 0x19 - ADD HL, DE */
+    opcode(1, 8, &cpu::ld_a_de),                                    /* 0x1A - LD A, (DE) */
+    opcode(1, 8, &cpu::dec_de),                                     /* 0x1B - DEC DE */
+    opcode(1, 4, &cpu::inc_e),                                      /* 0x1C - INC E */
+    opcode(1, 4, &cpu::dec_e),                                      /* 0x1D - DEC E */
+    opcode(2, 8, &cpu::ld_e_d8),                                    /* 0x1E - LD E, d8 */
+    opcode(1, 4, &cpu::rra),                                        /* 0x1F - RRA */
+
+    opcode(2, 12, &cpu::jr_nz_r8, 8),                               /* 0x20 - JR NZ, r8 */
+    opcode(3, 12, &cpu::ld_hl_d16),                                 /* 0x21 - LD HL, d16 */
+    opcode(1, 8, &cpu::ldi_hl_a),                                   /* 0x22 - LDI (HL), A */
+    opcode(1, 8, &cpu::inc_hl),                                     /* 0x23 - INC HL */
+    opcode(1, 4, &cpu::inc_h),                                      /* 0x24 - INC H */
+    opcode(1, 4, &cpu::dec_h),                                      /* 0x25 - DEC H */
+    opcode(2, 8, &cpu::ld_h_d8),                                    /* 0x26 - LD H, d8 */
+    opcode(1, 4, &cpu::daa),                                        /* 0x27 - DAA */
+    opcode(2, 12, &cpu::jr_z_r8, 8),                                /* 0x28 - JR Z, r8 */
+    opcode(1, 8, &cpu::add_hl_hl),                                  /* 0x29 - ADD HL, HL */
+    opcode(1, 8, &cpu::ldi_a_hl),                                   /* 0x2A - LDI A, (HL) */
+    opcode(1, 8, &cpu::dec_hl),                                     /* 0x2B - DEC HL */
+    opcode(1, 4, &cpu::inc_l),                                      /* 0x2C - INC L */
+    opcode(1, 4, &cpu::dec_l),                                      /* 0x2D - DEC L */
+    opcode(2, 8, &cpu::ld_l_d8),                                    /* 0x2E - LD L, d8 */
+    opcode(1, 4, &cpu::cpl),                                        /* 0x2F - CPL */
+
+    opcode(2, 12, &cpu::jr_nc_r8, 8),                               /* 0x30 - JR NC, r8 */
+    opcode(3, 12, &cpu::ld_sp_d16),                                 /* 0x31 - LD SP, d16 */
+    opcode(1, 8, &cpu::ldd_hl_a),                                   /* 0x32 - LDD (HL), A */
+    opcode(1, 8, &cpu::inc_sp),                                     /* 0x33 - INC SP */
+    opcode(1, 12, &cpu::inc_hl_),                                   /* 0x34 - INC (HL) */
+    opcode(1, 12, &cpu::dec_hl_),                                   /* 0x35 - DEC (HL) */
+    opcode(2, 12, &cpu::ld_hl_d8),                                  /* 0x36 - LD (HL), d8 */
+    opcode(1, 4, &cpu::scf),                                        /* 0x37 - SCF */
+    opcode(2, 12, &cpu::jr_c_r8, 8),                                /* 0x38 - JR C, r8 */
+    opcode(1, 8, &cpu::add_hl_sp),                                  /* 0x39 - ADD HL, SP */
+    opcode(1, 8, &cpu::ldd_a_hl),                                   /* 0x3A - LDD A, (HL) */
+    opcode(1, 8, &cpu::dec_sp),                                     /* 0x3B - DEC SP */
+    opcode(1, 4, &cpu::inc_a),                                      /* 0x3C - INC A */
+    opcode(1, 4, &cpu::dec_a),                                      /* 0x3D - DEC A */
+    opcode(2, 8, &cpu::ld_a_d8),                                    /* 0x3E - LD A, d8 */
+    opcode(1, 4, &cpu::ccf),                                        /* 0x3F - CCF */
+
+    opcode(1, 4, &cpu::ld_b_b),                                     /* 0x40 - LD B, B */
+    opcode(1, 4, &cpu::ld_b_c),                                     /* 0x41 - LD B, C */
+    opcode(1, 4, &cpu::ld_b_d),                                     /* 0x42 - LD B, D */
+    opcode(1, 4, &cpu::ld_b_e),                                     /* 0x43 - LD B, E */
+    opcode(1, 4, &cpu::ld_b_h),                                     /* 0x44 - LD B, H */
+    opcode(1, 4, &cpu::ld_b_l),                                     /* 0x45 - LD B, L */
+    opcode(1, 8, &cpu::ld_b_hl),                                    /* 0x46 - LD B, (HL) */
+    opcode(1, 4, &cpu::ld_b_a),                                     /* 0x47 - LD B, A */
+    opcode(1, 4, &cpu::ld_c_b),                                     /* 0x48 - LD C, B */
+    opcode(1, 4, &cpu::ld_c_c),                                     /* 0x49 - LD C, C */
+    opcode(1, 4, &cpu::ld_c_d),                                     /* 0x4A - LD C, D */
+    opcode(1, 4, &cpu::ld_c_e),                                     /* 0x4B - LD C, E */
+    opcode(1, 4, &cpu::ld_c_h),                                     /* 0x4C - LD C, H */
+    opcode(1, 4, &cpu::ld_c_l),                                     /* 0x4D - LD C, L */
+    opcode(1, 8, &cpu::ld_c_hl),                                    /* 0x4E - LD C, (HL) */
+    opcode(1, 4, &cpu::ld_c_a),                                     /* 0x4F - LD C, A */
+
+    opcode(1, 4, &cpu::ld_d_b),                                     /* 0x50 - LD D, B */
+    opcode(1, 4, &cpu::ld_d_c),                                     /* 0x51 - LD D, C */
+    opcode(1, 4, &cpu::ld_d_d),                                     /* 0x52 - LD D, D */
+    opcode(1, 4, &cpu::ld_d_e),                                     /* 0x53 - LD D, E */
+    opcode(1, 4, &cpu::ld_d_h),                                     /* 0x54 - LD D, H */
+    opcode(1, 4, &cpu::ld_d_l),                                     /* 0x55 - LD D, L */
+    opcode(1, 8, &cpu::ld_d_hl),                                    /* 0x56 - LD D, (HL) */
+    opcode(1, 4, &cpu::ld_d_a),                                     /* 0x57 - LD D, A */
+    opcode(1, 4, &cpu::ld_e_b),                                     /* 0x58 - LD E, B */
+    opcode(1, 4, &cpu::ld_e_c),                                     /* 0x59 - LD E, C */
+    opcode(1, 4, &cpu::ld_e_d),                                     /* 0x5A - LD E, D */
+    opcode(1, 4, &cpu::ld_e_e),                                     /* 0x5B - LD E, E */
+    opcode(1, 4, &cpu::ld_e_h),                                     /* 0x5C - LD E, H */
+    opcode(1, 4, &cpu::ld_e_l),                                     /* 0x5D - LD E, L */
+    opcode(1, 8, &cpu::ld_e_hl),                                    /* 0x5E - LD E, (HL) */
+    opcode(1, 4, &cpu::ld_e_a),                                     /* 0x5F - LD E, A */
+
+    opcode(1, 4, &cpu::ld_h_b),                                     /* 0x60 - LD H, B */
+    opcode(1, 4, &cpu::ld_h_c),                                     /* 0x61 - LD H, C */
+    opcode(1, 4, &cpu::ld_h_d),                                     /* 0x62 - LD H, D */
+    opcode(1, 4, &cpu::ld_h_e),                                     /* 0x63 - LD H, E */
+    opcode(1, 4, &cpu::ld_h_h),                                     /* 0x64 - LD H, H */
+    opcode(1, 4, &cpu::ld_h_l),                                     /* 0x65 - LD H, L */
+    opcode(1, 8, &cpu::ld_h_hl),                                    /* 0x66 - LD H, (HL) */
+    opcode(1, 4, &cpu::ld_h_a),                                     /* 0x67 - LD H, A */
+    opcode(1, 4, &cpu::ld_l_b),                                     /* 0x68 - LD L, B */
+    opcode(1, 4, &cpu::ld_l_c),                                     /* 0x69 - LD L, C */
+    opcode(1, 4, &cpu::ld_l_d),                                     /* 0x6A - LD L, D */
+    opcode(1, 4, &cpu::ld_l_e),                                     /* 0x6B - LD L, E */
+    opcode(1, 4, &cpu::ld_l_h),                                     /* 0x6C - LD L, H */
+    opcode(1, 4, &cpu::ld_l_l),                                     /* 0x6D - LD L, L */
+    opcode(1, 8, &cpu::ld_l_hl),                                    /* 0x6E - LD L, (HL) */
+    opcode(1, 4, &cpu::ld_l_a),                                     /* 0x6F - LD L, A */
+
+    opcode(1, 8, &cpu::ld_hl_b),                                    /* 0x70 - LD (HL), B */
+    opcode(1, 8, &cpu::ld_hl_c),                                    /* 0x71 - LD (HL), C */
+    opcode(1, 8, &cpu::ld_hl_d),                                    /* 0x72 - LD (HL), D */
+    opcode(1, 8, &cpu::ld_hl_e),                                    /* 0x73 - LD (HL), E */
+    opcode(1, 8, &cpu::ld_hl_h),                                    /* 0x74 - LD (HL), H */
+    opcode(1, 8, &cpu::ld_hl_l),                                    /* 0x75 - LD (HL), L */
+    opcode(1, 4, &cpu::halt),                                       /* 0x76 - HALT */
+    opcode(1, 8, &cpu::ld_hl_a),                                    /* 0x77 - LD (HL), A */
+    opcode(1, 4, &cpu::ld_a_b),                                     /* 0x78 - LD A, B */
+    opcode(1, 4, &cpu::ld_a_c),                                     /* 0x79 - LD A, C */
+    opcode(1, 4, &cpu::ld_a_d),                                     /* 0x7A - LD A, D */
+    opcode(1, 4, &cpu::ld_a_e),                                     /* 0x7B - LD A, E */
+    opcode(1, 4, &cpu::ld_a_h),                                     /* 0x7C - LD A, H */
+    opcode(1, 4, &cpu::ld_a_l),                                     /* 0x7D - LD A, L */
+    opcode(1, 8, &cpu::ld_a_hl),                                    /* 0x7E - LD A, (HL) */
+    opcode(1, 4, &cpu::ld_a_a),                                     /* 0x7F - LD A, A */
+
+    opcode(1, 4, &cpu::add_a_b),                                    /* 0x80 - ADD A, B */
+    opcode(1, 4, &cpu::add_a_c),                                    /* 0x81 - ADD A, C */
+    opcode(1, 4, &cpu::add_a_d),                                    /* 0x82 - ADD A, D */
+    opcode(1, 4, &cpu::add_a_e),                                    /* 0x83 - ADD A, E */
+    opcode(1, 4, &cpu::add_a_h),                                    /* 0x84 - ADD A, H */
+    opcode(1, 4, &cpu::add_a_l),                                    /* 0x85 - ADD A, L */
+    opcode(1, 8, &cpu::add_a_hl),                                   /* 0x86 - ADD A, (HL) */
+    opcode(1, 4, &cpu::add_a_a),                                    /* 0x87 - ADD A, A */
+    opcode(1, 4, &cpu::adc_a_b),                                    /* 0x88 - ADC A, B */
+    opcode(1, 4, &cpu::adc_a_c),                                    /* 0x89 - ADC A, C */
+    opcode(1, 4, &cpu::adc_a_d),                                    /* 0x8A - ADC A, D */
+    opcode(1, 4, &cpu::adc_a_e),                                    /* 0x8B - ADC A, E */
+    opcode(1, 4, &cpu::adc_a_h),                                    /* 0x8C - ADC A, H */
+    opcode(1, 4, &cpu::adc_a_l),                                    /* 0x8D - ADC A, L */
+    opcode(1, 8, &cpu::adc_a_hl),                                   /* 0x8E - ADC A, (HL) */
+    opcode(1, 4, &cpu::adc_a_a),                                    /* 0x8F - ADC A, A */
+
+    opcode(1, 4, &cpu::sub_b),                                      /* 0x90 - SUB B */
+    opcode(1, 4, &cpu::sub_c),                                      /* 0x91 - SUB C */
+    opcode(1, 4, &cpu::sub_d),                                      /* 0x92 - SUB D */
+    opcode(1, 4, &cpu::sub_e),                                      /* 0x93 - SUB E */
+    opcode(1, 4, &cpu::sub_h),                                      /* 0x94 - SUB H */
+    opcode(1, 4, &cpu::sub_l),                                      /* 0x95 - SUB L */
+    opcode(1, 8, &cpu::sub_hl),                                     /* 0x96 - SUB (HL) */
+    opcode(1, 4, &cpu::sub_a),                                      /* 0x97 - SUB A */
+    opcode(1, 4, &cpu::sbc_a_b),                                    /* 0x98 - SBC A, B */
+    opcode(1, 4, &cpu::sbc_a_c),                                    /* 0x99 - SBC A, C */
+    opcode(1, 4, &cpu::sbc_a_d),                                    /* 0x9A - SBC A, D */
+    opcode(1, 4, &cpu::sbc_a_e),                                    /* 0x9B - SBC A, E */
+    opcode(1, 4, &cpu::sbc_a_h),                                    /* 0x9C - SBC A, H */
+    opcode(1, 4, &cpu::sbc_a_l),                                    /* 0x9D - SBC A, L */
+    opcode(1, 8, &cpu::sbc_a_hl),                                   /* 0x9E - SBC A, (HL) */
+    opcode(1, 4, &cpu::sbc_a_a),                                    /* 0x9F - SBC A, A */
+
+    opcode(1, 4, &cpu::and_b),                                      /* 0xA0 - AND B */
+    opcode(1, 4, &cpu::and_c),                                      /* 0xA1 - AND C */
+    opcode(1, 4, &cpu::and_d),                                      /* 0xA2 - AND D */
+    opcode(1, 4, &cpu::and_e),                                      /* 0xA3 - AND E */
+    opcode(1, 4, &cpu::and_h),                                      /* 0xA4 - AND H */
+    opcode(1, 4, &cpu::and_l),                                      /* 0xA5 - AND L */
+    opcode(1, 8, &cpu::and_hl),                                     /* 0xA6 - AND (HL) */
+    opcode(1, 4, &cpu::and_a),                                      /* 0xA7 - AND A */
+    opcode(1, 4, &cpu::xor_b),                                      /* 0xA8 - XOR B */
+    opcode(1, 4, &cpu::xor_c),                                      /* 0xA9 - XOR C */
+    opcode(1, 4, &cpu::xor_d),                                      /* 0xAA - XOR D */
+    opcode(1, 4, &cpu::xor_e),                                      /* 0xAB - XOR E */
+    opcode(1, 4, &cpu::xor_h),                                      /* 0xAC - XOR H */
+    opcode(1, 4, &cpu::xor_l),                                      /* 0xAD - XOR L */
+    opcode(1, 8, &cpu::xor_hl),                                     /* 0xAE - XOR (HL) */
+    opcode(1, 4, &cpu::xor_a),                                      /* 0xAF - XOR A */
+
+    opcode(1, 4, &cpu::or_b),                                       /* 0xB0 - OR B */
+    opcode(1, 4, &cpu::or_c),                                       /* 0xB1 - OR C */
+    opcode(1, 4, &cpu::or_d),                                       /* 0xB2 - OR D */
+    opcode(1, 4, &cpu::or_e),                                       /* 0xB3 - OR E */
+    opcode(1, 4, &cpu::or_h),                                       /* 0xB4 - OR H */
+    opcode(1, 4, &cpu::or_l),                                       /* 0xB5 - OR L */
+    opcode(1, 8, &cpu::or_hl),                                      /* 0xB6 - OR (HL) */
+    opcode(1, 4, &cpu::or_a),                                       /* 0xB7 - OR A */
+    opcode(1, 4, &cpu::cp_b),                                       /* 0xB8 - CP B */
+    opcode(1, 4, &cpu::cp_c),                                       /* 0xB9 - CP C */
+    opcode(1, 4, &cpu::cp_d),                                       /* 0xBA - CP D */
+    opcode(1, 4, &cpu::cp_e),                                       /* 0xBB - CP E */
+    opcode(1, 4, &cpu::cp_h),                                       /* 0xBC - CP H */
+    opcode(1, 4, &cpu::cp_l),                                       /* 0xBD - CP L */
+    opcode(1, 8, &cpu::cp_hl),                                      /* 0xBE - CP (HL) */
+    opcode(1, 4, &cpu::cp_a),                                       /* 0xBF - CP A */
+
+    opcode(1, 20, &cpu::ret_nz, 8),                                 /* 0xC0 - RET NZ */
+    opcode(1, 12, &cpu::pop_bc),                                    /* 0xC1 - POP BC */
+    opcode(3, 16, &cpu::jp_nz_a16, 12),                             /* 0xC2 - JP NZ, a16 */
+    opcode(3, 16, &cpu::jp_a16),                                    /* 0xC3 - JP a16 */
+    opcode(3, 24, &cpu::call_nz_a16, 12),                           /* 0xC4 - CALL NZ, a16 */
+    opcode(1, 16, &cpu::push_bc),                                   /* 0xC5 - PUSH BC */
+    opcode(2, 8, &cpu::add_a_d8),                                   /* 0xC6 - ADD A, d8 */
+    opcode(1, 16, &cpu::rst_00h),                                   /* 0xC7 - RST 00h */
+    opcode(1, 20, &cpu::ret_z, 8),                                  /* 0xC8 - RET Z */
+    opcode(1, 16, &cpu::ret),                                       /* 0xC9 - RET */
+    opcode(3, 16, &cpu::jp_z_a16, 12),                              /* 0xCA - JP Z, a16 */
+    opcode(1, 4, &cpu::prefix_cb),                                  /* 0xCB - PREFIX CB */
+    opcode(3, 24, &cpu::call_z_a16, 12),                            /* 0xCC - CALL Z, a16 */
+    opcode(3, 24, &cpu::call_a16),                                  /* 0xCD - CALL a16 */
+    opcode(2, 8, &cpu::adc_a_d8),                                   /* 0xCE - ADC A, d8 */
+    opcode(1, 16, &cpu::rst_08h),                                   /* 0xCF - RST 08h */
+
+    opcode(1, 20, &cpu::ret_nc, 8),                                 /* 0xD0 - RET NC */
+    opcode(1, 12, &cpu::pop_de),                                    /* 0xD1 - POP DE */
+    opcode(3, 16, &cpu::jp_nc_a16, 12),                             /* 0xD2 - JP NC, a16 */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xD3 - NOT IMPL */
+    opcode(3, 24, &cpu::call_nc_a16, 12),                           /* 0xD4 - CALL NC, a16 */
+    opcode(1, 16, &cpu::push_de),                                   /* 0xD5 - PUSH DE */
+    opcode(2, 8, &cpu::sub_d8),                                     /* 0xD6 - SUB d8 */
+    opcode(1, 16, &cpu::rst_10h),                                   /* 0xD7 - RST 10h */
+    opcode(1, 20, &cpu::ret_c, 8),                                  /* 0xD8 - RET C */
+    opcode(1, 16, &cpu::reti),                                      /* 0xD9 - RETI */
+    opcode(3, 16, &cpu::jp_c_a16, 12),                              /* 0xDA - JP C, a16 */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xDB - NOT IMPL */
+    opcode(3, 24, &cpu::call_c_a16, 12),                            /* 0xDC - CALL C, a16 */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xDD - NOT IMPL */
+    opcode(2, 8, &cpu::sbc_a_d8),                                   /* 0xDE - SBC A, d8 */
+    opcode(1, 16, &cpu::rst_18h),                                   /* 0xDF - RST 18h */
+
+    opcode(2, 12, &cpu::ldh_a8_a),                                  /* 0xE0 - LDH (a8), A */
+    opcode(1, 12, &cpu::pop_hl),                                    /* 0xE1 - POP HL */
+    opcode(2, 8, &cpu::ld_c_a_),                                    /* 0xE2 - LD (C), A */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xE3 - NOT IMPL */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xE4 - NOT IMPL */
+    opcode(1, 16, &cpu::push_hl),                                   /* 0xE5 - PUSH HL */
+    opcode(2, 8, &cpu::and_d8),                                     /* 0xE6 - AND d8 */
+    opcode(1, 16, &cpu::rst_20h),                                   /* 0xE7 - RST 20h */
+    opcode(2, 16, &cpu::add_sp_r8),                                 /* 0xE8 - ADD SP, r8 */
+    opcode(1, 4, &cpu::jp_hl),                                      /* 0xE9 - JP (HL) */
+    opcode(3, 16, &cpu::ld_a16_a),                                  /* 0xEA - LD (a16), A */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xEB - NOT IMPL */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xEC - NOT IMPL */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xED - NOT IMPL */
+    opcode(2, 8, &cpu::xor_d8),                                     /* 0xEE - XOR d8 */
+    opcode(1, 16, &cpu::rst_28h),                                   /* 0xEF - RST 28h */
+
+    opcode(2, 12, &cpu::ldh_a_a8),                                  /* 0xF0 - LDH A, (a8) */
+    opcode(1, 12, &cpu::pop_af),                                    /* 0xF1 - POP AF */
+    opcode(2, 8, &cpu::ld_a_c_),                                    /* 0xF2 - LD A, (C) */
+    opcode(1, 4, &cpu::di),                                         /* 0xF3 - DI */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xF4 - NOT IMPL */
+    opcode(1, 16, &cpu::push_af),                                   /* 0xF5 - PUSH AF */
+    opcode(2, 8, &cpu::or_d8),                                      /* 0xF6 - OR d8 */
+    opcode(1, 16, &cpu::rst_30h),                                   /* 0xF7 - RST 30h */
+    opcode(2, 12, &cpu::ldhl_sp_r8),                                /* 0xF8 - LDHL SP, r8 */
+    opcode(1, 8, &cpu::ld_sp_hl),                                   /* 0xF9 - LD SP, HL */
+    opcode(3, 16, &cpu::ld_a_a16),                                  /* 0xFA - LD A, (a16) */
+    opcode(1, 4, &cpu::ei),                                         /* 0xFB - EI */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xFC - NOT IMPL */
+    opcode(1, 1, &cpu::not_impl),                                   /* 0xFD - NOT IMPL */
+    opcode(2, 8, &cpu::cp_d8),                                      /* 0xFE - CP d8 */
+    opcode(1, 16, &cpu::rst_38h)                                    /* 0xFF - RST 38h */
+};
+
+//2-bytes opcodes, 8 per row : B, C, D, E, H, L, (HL), A
+#define CB_GROUP(func, arg)                                     \
+    opcode(2, 8, &cpu::func<arg, 0>),                           \
+    opcode(2, 8, &cpu::func<arg, 1>),                           \
+    opcode(2, 8, &cpu::func<arg, 2>),                           \
+    opcode(2, 8, &cpu::func<arg, 3>),                           \
+    opcode(2, 8, &cpu::func<arg, 4>),                           \
+    opcode(2, 8, &cpu::func<arg, 5>),                           \
+    opcode(2, 16, &cpu::func<arg, 6>),                          \
+    opcode(2, 8, &cpu::func<arg, 7>)
+
+constexpr cpu::opcode cpu::extended_opcodes_table[256] =
+{
+    CB_GROUP(cb_shift, CB_RLC),                                         /* 0xCB00 - 0xCB07 - RLC */
+    CB_GROUP(cb_shift, CB_RRC),                                         /* 0xCB08 - 0xCB0F - RRC */
+
+    CB_GROUP(cb_shift, CB_RL),                                          /* 0xCB10 - 0xCB17 - RL */
+    CB_GROUP(cb_shift, CB_RR),                                          /* 0xCB18 - 0xCB1F - RR */
+
+    CB_GROUP(cb_shift, CB_SLA),                                         /* 0xCB20 - 0xCB27 - SLA */
+    CB_GROUP(cb_shift, CB_SRA),                                         /* 0xCB28 - 0xCB2F - SRA */
+
+    CB_GROUP(cb_shift, CB_SWAP),                                        /* 0xCB30 - 0xCB37 - SWAP */
+    CB_GROUP(cb_shift, CB_SRL),                                         /* 0xCB38 - 0xCB3F - SRL */
+
+    CB_GROUP(cb_bit, 0),                                                /* 0xCB40 - 0xCB47 - BIT 0 */
+    CB_GROUP(cb_bit, 1),                                                /* 0xCB48 - 0xCB4F - BIT 1 */
+
+    CB_GROUP(cb_bit, 2),                                                /* 0xCB50 - 0xCB57 - BIT 2 */
+    CB_GROUP(cb_bit, 3),                                                /* 0xCB58 - 0xCB5F - BIT 3 */
+
+    CB_GROUP(cb_bit, 4),                                                /* 0xCB60 - 0xCB67 - BIT 4 */
+    CB_GROUP(cb_bit, 5),                                                /* 0xCB68 - 0xCB6F - BIT 5 */
+
+    CB_GROUP(cb_bit, 6),                                                /* 0xCB70 - 0xCB77 - BIT 6 */
+    CB_GROUP(cb_bit, 7),                                                /* 0xCB78 - 0xCB7F - BIT 7 */
+
+    CB_GROUP(cb_res, 0),                                                /* 0xCB80 - 0xCB87 - RES 0 */
+    CB_GROUP(cb_res, 1),                                                /* 0xCB88 - 0xCB8F - RES 1 */
+
+    CB_GROUP(cb_res, 2),                                                /* 0xCB90 - 0xCB97 - RES 2 */
+    CB_GROUP(cb_res, 3),                                                /* 0xCB98 - 0xCB9F - RES 3 */
+
+    CB_GROUP(cb_res, 4),                                                /* 0xCBA0 - 0xCBA7 - RES 4 */
+    CB_GROUP(cb_res, 5),                                                /* 0xCBA8 - 0xCBAF - RES 5 */
+
+    CB_GROUP(cb_res, 6),                                                /* 0xCBB0 - 0xCBB7 - RES 6 */
+    CB_GROUP(cb_res, 7),                                                /* 0xCBB8 - 0xCBBF - RES 7 */
+
+    CB_GROUP(cb_set, 0),                                                /* 0xCBC0 - 0xCBC7 - SET 0 */
+    CB_GROUP(cb_set, 1),                                                /* 0xCBC8 - 0xCBCF - SET 1 */
+
+    CB_GROUP(cb_set, 2),                                                /* 0xCBD0 - 0xCBD7 - SET 2 */
+    CB_GROUP(cb_set, 3),                                                /* 0xCBD8 - 0xCBDF - SET 3 */
+
+    CB_GROUP(cb_set, 4),                                                /* 0xCBE0 - 0xCBE7 - SET 4 */
+    CB_GROUP(cb_set, 5),                                                /* 0xCBE8 - 0xCBEF - SET 5 */
+
+    CB_GROUP(cb_set, 6),                                                /* 0xCBF0 - 0xCBF7 - SET 6 */
+    CB_GROUP(cb_set, 7)                                                 /* 0xCBF8 - 0xCBFF - SET 7 */
+};
+
+#undef CB_GROUP
+
+//cold data, out of the opcodes tables : only the debugger and the tracer read them (see get_mnemonic())
+constexpr const char* cpu::opcodes_mnemonics[256] =
+{
+    "NOP",                          /* 0x00 */
+    "LD BC,d16",                    /* 0x01 */
+    "LD (BC),A",                    /* 0x02 */
+    "INC BC",                       /* 0x03 */
+    "INC B",                        /* 0x04 */
+    "DEC B",                        /* 0x05 */
+    "LD B,d8",                      /* 0x06 */
+    "RLCA",                         /* 0x07 */
+    "LD (a16), SP",                 /* 0x08 */
+    "ADD HL, BC",                   /* 0x09 */
+    "LD A, (BC)",                   /* 0x0A */
+    "DEC BC",                       /* 0x0B */
+    "INC C",                        /* 0x0C */
+    "DEC C",                        /* 0x0D */
+    "LD C, d8",                     /* 0x0E */
+    "RRCA",                         /* 0x0F */
+    "STOP 0",                       /* 0x10 */
+    "LD DE,d16",                    /* 0x11 */
+    "LD (DE),A",                    /* 0x12 */
+    "INC DE",                       /* 0x13 */
+    "INC D",                        /* 0x14 */
+    "DEC D",                        /* 0x15 */
+    "LD D,d8",                      /* 0x16 */
+    "RLA",                          /* 0x17 */
+    "JR r8",                        /* 0x18 */
+    "ADD HL, DE",                   /* 0x19 */
+    "LD A, (DE)",                   /* 0x1A */
+    "DEC DE",                       /* 0x1B */
+    "INC E",                        /* 0x1C */
+    "DEC E",                        /* 0x1D */
+    "LD E, d8",                     /* 0x1E */
+    "RRA",                          /* 0x1F */
+    "JR NZ,r8",                     /* 0x20 */
+    "LD HL,d16",                    /* 0x21 */
+    "LDI (HL),A",                   /* 0x22 */
+    "INC HL",                       /* 0x23 */
+    "INC H",                        /* 0x24 */
+    "DEC H",                        /* 0x25 */
+    "LD H,d8",                      /* 0x26 */
+    "DAA",                          /* 0x27 */
+    "JR Z,r8",                      /* 0x28 */
+    "ADD HL, HL",                   /* 0x29 */
+    "LDI A, (HL)",                  /* 0x2A */
+    "DEC HL",                       /* 0x2B */
+    "INC L",                        /* 0x2C */
+    "DEC L",                        /* 0x2D */
+    "LD L, d8",                     /* 0x2E */
+    "CPL",                          /* 0x2F */
+    "JR NC,r8",                     /* 0x30 */
+    "LD SP,d16",                    /* 0x31 */
+    "LDD (HL),A",                   /* 0x32 */
+    "INC SP",                       /* 0x33 */
+    "INC (HL)",                     /* 0x34 */
+    "DEC (HL)",                     /* 0x35 */
+    "LD (HL),d8",                   /* 0x36 */
+    "SCF",                          /* 0x37 */
+    "JR C,r8",                      /* 0x38 */
+    "ADD HL, SP",                   /* 0x39 */
+    "LDD A, (HL)",                  /* 0x3A */
+    "DEC SP",                       /* 0x3B */
+    "INC A",                        /* 0x3C */
+    "DEC A",                        /* 0x3D */
+    "LD A, d8",                     /* 0x3E */
+    "CCF",                          /* 0x3F */
+    "LD B, B",                      /* 0x40 */
+    "LD B, C",                      /* 0x41 */
+    "LD B, D",                      /* 0x42 */
+    "LD B, E",                      /* 0x43 */
+    "LD B, H",                      /* 0x44 */
+    "LD B, L",                      /* 0x45 */
+    "LD B, (HL)",                   /* 0x46 */
+    "LD B, A",                      /* 0x47 */
+    "LD C, B",                      /* 0x48 */
+    "LD C, C",                      /* 0x49 */
+    "LD C, D",                      /* 0x4A */
+    "LD C, E",                      /* 0x4B */
+    "LD C, H",                      /* 0x4C */
+    "LD C, L",                      /* 0x4D */
+    "LD C, (HL)",                   /* 0x4E */
+    "LD C, A",                      /* 0x4F */
+    "LD D, B",                      /* 0x50 */
+    "LD D, C",                      /* 0x51 */
+    "LD D, D",                      /* 0x52 */
+    "LD D, E",                      /* 0x53 */
+    "LD D, H",                      /* 0x54 */
+    "LD D, L",                      /* 0x55 */
+    "LD D, (HL)",                   /* 0x56 */
+    "LD D, A",                      /* 0x57 */
+    "LD E, B",                      /* 0x58 */
+    "LD E, C",                      /* 0x59 */
+    "LD E, D",                      /* 0x5A */
+    "LD E, E",                      /* 0x5B */
+    "LD E, H",                      /* 0x5C */
+    "LD E, L",                      /* 0x5D */
+    "LD E, (HL)",                   /* 0x5E */
+    "LD E, A",                      /* 0x5F */
+    "LD H, B",                      /* 0x60 */
+    "LD H, C",                      /* 0x61 */
+    "LD H, D",                      /* 0x62 */
+    "LD H, E",                      /* 0x63 */
+    "LD H, H",                      /* 0x64 */
+    "LD H, L",                      /* 0x65 */
+    "LD H, (HL)",                   /* 0x66 */
+    "LD H, A",                      /* 0x67 */
+    "LD L, B",                      /* 0x68 */
+    "LD L, C",                      /* 0x69 */
+    "LD L, D",                      /* 0x6A */
+    "LD L, E",                      /* 0x6B */
+    "LD L, H",                      /* 0x6C */
+    "LD L, L",                      /* 0x6D */
+    "LD L, (HL)",                   /* 0x6E */
+    "LD L, A",                      /* 0x6F */
+    "LD (HL), B",                   /* 0x70 */
+    "LD (HL), C",                   /* 0x71 */
+    "LD (HL), D",                   /* 0x72 */
+    "LD (HL), E",                   /* 0x73 */
+    "LD (HL), H",                   /* 0x74 */
+    "LD (HL), L",                   /* 0x75 */
+    "HALT",                         /* 0x76 */
+    "LD (HL), A",                   /* 0x77 */
+    "LD A, B",                      /* 0x78 */
+    "LD A, C",                      /* 0x79 */
+    "LD A, D",                      /* 0x7A */
+    "LD A, E",                      /* 0x7B */
+    "LD A, H",                      /* 0x7C */
+    "LD A, L",                      /* 0x7D */
+    "LD A, (HL)",                   /* 0x7E */
+    "LD A, A",                      /* 0x7F */
+    "ADD A, B",                     /* 0x80 */
+    "ADD A, C",                     /* 0x81 */
+    "ADD A, D",                     /* 0x82 */
+    "ADD A, E",                     /* 0x83 */
+    "ADD A, H",                     /* 0x84 */
+    "ADD A, L",                     /* 0x85 */
+    "ADD A, (HL)",                  /* 0x86 */
+    "ADD A, A",                     /* 0x87 */
+    "ADC A, B",                     /* 0x88 */
+    "ADC A, C",                     /* 0x89 */
+    "ADC A, D",                     /* 0x8A */
+    "ADC A, E",                     /* 0x8B */
+    "ADC A, H",                     /* 0x8C */
+    "ADC A, L",                     /* 0x8D */
+    "ADC A, (HL)",                  /* 0x8E */
+    "ADC A, A",                     /* 0x8F */
+    "SUB B",                        /* 0x90 */
+    "SUB C",                        /* 0x91 */
+    "SUB D",                        /* 0x92 */
+    "SUB E",                        /* 0x93 */
+    "SUB H",                        /* 0x94 */
+    "SUB L",                        /* 0x95 */
+    "SUB (HL)",                     /* 0x96 */
+    "SUB A",                        /* 0x97 */
+    "SBC A, B",                     /* 0x98 */
+    "SBC A, C",                     /* 0x99 */
+    "SBC A, D",                     /* 0x9A */
+    "SBC A, E",                     /* 0x9B */
+    "SBC A, H",                     /* 0x9C */
+    "SBC A, L",                     /* 0x9D */
+    "SBC A, (HL)",                  /* 0x9E */
+    "SBC A, A",                     /* 0x9F */
+    "AND B",                        /* 0xA0 */
+    "AND C",                        /* 0xA1 */
+    "AND D",                        /* 0xA2 */
+    "AND E",                        /* 0xA3 */
+    "AND H",                        /* 0xA4 */
+    "AND L",                        /* 0xA5 */
+    "AND (HL)",                     /* 0xA6 */
+    "AND A",                        /* 0xA7 */
+    "XOR B",                        /* 0xA8 */
+    "XOR C",                        /* 0xA9 */
+    "XOR D",                        /* 0xAA */
+    "XOR E",                        /* 0xAB */
+    "XOR H",                        /* 0xAC */
+    "XOR L",                        /* 0xAD */
+    "XOR (HL)",                     /* 0xAE */
+    "XOR A",                        /* 0xAF */
+    "OR B",                         /* 0xB0 */
+    "OR C",                         /* 0xB1 */
+    "OR D",                         /* 0xB2 */
+    "OR E",                         /* 0xB3 */
+    "OR H",                         /* 0xB4 */
+    "OR L",                         /* 0xB5 */
+    "OR (HL)",                      /* 0xB6 */
+    "OR A",                         /* 0xB7 */
+    "CP B",                         /* 0xB8 */
+    "CP C",                         /* 0xB9 */
+    "CP D",                         /* 0xBA */
+    "CP E",                         /* 0xBB */
+    "CP H",                         /* 0xBC */
+    "CP L",                         /* 0xBD */
+    "CP (HL)",                      /* 0xBE */
+    "CP A",                         /* 0xBF */
+    "RET NZ",                       /* 0xC0 */
+    "POP BC",                       /* 0xC1 */
+    "JP NZ, a16",                   /* 0xC2 */
+    "JP a16",                       /* 0xC3 */
+    "CALL NZ, a16",                 /* 0xC4 */
+    "PUSH BC",                      /* 0xC5 */
+    "ADD A, d8",                    /* 0xC6 */
+    "RST 00h",                      /* 0xC7 */
+    "RET Z",                        /* 0xC8 */
+    "RET",                          /* 0xC9 */
+    "JP Z, a16",                    /* 0xCA */
+    "PREFIX CB",                    /* 0xCB */
+    "CALL Z, a16",                  /* 0xCC */
+    "CALL a16",                     /* 0xCD */
+    "ADC A, d8",                    /* 0xCE */
+    "RST 08h",                      /* 0xCF */
+    "RET NC",                       /* 0xD0 */
+    "POP DE",                       /* 0xD1 */
+    "JP NC, a16",                   /* 0xD2 */
+    "NOT IMPL",                     /* 0xD3 */
+    "CALL NC, a16",                 /* 0xD4 */
+    "PUSH DE",                      /* 0xD5 */
+    "SUB d8",                       /* 0xD6 */
+    "RST 10h",                      /* 0xD7 */
+    "RET C",                        /* 0xD8 */
+    "RETI",                         /* 0xD9 */
+    "JP C, a16",                    /* 0xDA */
+    "NOT IMPL",                     /* 0xDB */
+    "CALL C, a16",                  /* 0xDC */
+    "NOT IMPL",                     /* 0xDD */
+    "SBC A, d8",                    /* 0xDE */
+    "RST 18h",                      /* 0xDF */
+    "LDH (a8), A",                  /* 0xE0 */
+    "POP HL",                       /* 0xE1 */
+    "LD (C), A",                    /* 0xE2 */
+    "NOT IMPL",                     /* 0xE3 */
+    "NOT IMPL",                     /* 0xE4 */
+    "PUSH HL",                      /* 0xE5 */
+    "AND d8",                       /* 0xE6 */
+    "RST 20h",                      /* 0xE7 */
+    "ADD SP, r8",                   /* 0xE8 */
+    "JP (HL)",                      /* 0xE9 */
+    "LD (a16), A",                  /* 0xEA */
+    "NOT IMPL",                     /* 0xEB */
+    "NOT IMPL",                     /* 0xEC */
+    "NOT IMPL",                     /* 0xED */
+    "XOR d8",                       /* 0xEE */
+    "RST 28h",                      /* 0xEF */
+    "LDH A, (a8)",                  /* 0xF0 */
+    "POP AF",                       /* 0xF1 */
+    "LD A, (C)",                    /* 0xF2 */
+    "DI",                           /* 0xF3 */
+    "NOT IMPL",                     /* 0xF4 */
+    "PUSH AF",                      /* 0xF5 */
+    "OR d8",                        /* 0xF6 */
+    "RST 30h",                      /* 0xF7 */
+    "LDHL SP, r8",                  /* 0xF8 */
+    "LD SP, HL",                    /* 0xF9 */
+    "LD A, (a16)",                  /* 0xFA */
+    "EI",                           /* 0xFB */
+    "NOT IMPL",                     /* 0xFC */
+    "NOT IMPL",                     /* 0xFD */
+    "CP d8",                        /* 0xFE */
+    "RST 38h"                       /* 0xFF */
+};
+
+#define CB_MNEMONICS(mnemonic) \
+    mnemonic " B", mnemonic " C", mnemonic " D", mnemonic " E", mnemonic " H", mnemonic " L", mnemonic " (HL)", mnemonic " A"
+
+constexpr const char* cpu::extended_opcodes_mnemonics[256] =
+{
+    CB_MNEMONICS("RLC"),                                                /* 0xCB00 - 0xCB07 - RLC */
+    CB_MNEMONICS("RRC"),                                                /* 0xCB08 - 0xCB0F - RRC */
+
+    CB_MNEMONICS("RL"),                                                 /* 0xCB10 - 0xCB17 - RL */
+    CB_MNEMONICS("RR"),                                                 /* 0xCB18 - 0xCB1F - RR */
+    CB_MNEMONICS("SLA"),                                                /* 0xCB20 - 0xCB27 - SLA */
+    CB_MNEMONICS("SRA"),                                                /* 0xCB28 - 0xCB2F - SRA */
+    CB_MNEMONICS("SWAP"),                                               /* 0xCB30 - 0xCB37 - SWAP */
+    CB_MNEMONICS("SRL"),                                                /* 0xCB38 - 0xCB3F - SRL */
+    CB_MNEMONICS("BIT 0,"),                                             /* 0xCB40 - 0xCB47 - BIT 0 */
+    CB_MNEMONICS("BIT 1,"),                                             /* 0xCB48 - 0xCB4F - BIT 1 */
+    CB_MNEMONICS("BIT 2,"),                                             /* 0xCB50 - 0xCB57 - BIT 2 */
+    CB_MNEMONICS("BIT 3,"),                                             /* 0xCB58 - 0xCB5F - BIT 3 */
+    CB_MNEMONICS("BIT 4,"),                                             /* 0xCB60 - 0xCB67 - BIT 4 */
+    CB_MNEMONICS("BIT 5,"),                                             /* 0xCB68 - 0xCB6F - BIT 5 */
+    CB_MNEMONICS("BIT 6,"),                                             /* 0xCB70 - 0xCB77 - BIT 6 */
+    CB_MNEMONICS("BIT 7,"),                                             /* 0xCB78 - 0xCB7F - BIT 7 */
+    CB_MNEMONICS("RES 0,"),                                             /* 0xCB80 - 0xCB87 - RES 0 */
+    CB_MNEMONICS("RES 1,"),                                             /* 0xCB88 - 0xCB8F - RES 1 */
+    CB_MNEMONICS("RES 2,"),                                             /* 0xCB90 - 0xCB97 - RES 2 */
+    CB_MNEMONICS("RES 3,"),                                             /* 0xCB98 - 0xCB9F - RES 3 */
+    CB_MNEMONICS("RES 4,"),                                             /* 0xCBA0 - 0xCBA7 - RES 4 */
+    CB_MNEMONICS("RES 5,"),                                             /* 0xCBA8 - 0xCBAF - RES 5 */
+    CB_MNEMONICS("RES 6,"),                                             /* 0xCBB0 - 0xCBB7 - RES 6 */
+    CB_MNEMONICS("RES 7,"),                                             /* 0xCBB8 - 0xCBBF - RES 7 */
+    CB_MNEMONICS("SET 0,"),                                             /* 0xCBC0 - 0xCBC7 - SET 0 */
+    CB_MNEMONICS("SET 1,"),                                             /* 0xCBC8 - 0xCBCF - SET 1 */
+    CB_MNEMONICS("SET 2,"),                                             /* 0xCBD0 - 0xCBD7 - SET 2 */
+    CB_MNEMONICS("SET 3,"),                                             /* 0xCBD8 - 0xCBDF - SET 3 */
+    CB_MNEMONICS("SET 4,"),                                             /* 0xCBE0 - 0xCBE7 - SET 4 */
+    CB_MNEMONICS("SET 5,"),                                             /* 0xCBE8 - 0xCBEF - SET 5 */
+    CB_MNEMONICS("SET 6,"),                                             /* 0xCBF0 - 0xCBF7 - SET 6 */
+    CB_MNEMONICS("SET 7,")                                              /* 0xCBF8 - 0xCBFF - SET 7 */
+};
+
+#undef CB_MNEMONICS
+
+//superinstructions : length and cycles are the sums of the two opcodes, taken from opcodes_table
+#define FUSED(mnemonic, first, second)                                                  \
+    { first, second, mnemonic, opcode(                                                  \
+        opcodes_table[first].length + opcodes_table[second].length,                     \
+        opcodes_table[first].cycles + opcodes_table[second].cycles,                     \
+        &cpu::fused<first, second>,                                                     \
+        opcodes_table[first].cycles + opcodes_table[second].not_exec_cycles) }
+
+/* Pairs picked by hand, not from a profile : the usual bodies of copy loops (LDI A, (HL) / LD (DE), A),
+ * counters (DEC B / JR NZ), polling loops (LD A, (a16) / AND d8) and compare-and-branch (CP d8 / JR Z).
+ * The first opcode of a pair must neither end a block nor write to memory, so that a block
+ * still stops right after any write into its own page.
+ */
+constexpr cpu::fused_opcode cpu::fused_opcodes_table[FUSED_OPCODES_COUNT] =
+{
+    FUSED("LDI A, (HL) / LD (DE), A", 0x2A, 0x12),
+    FUSED("DEC B / JR NZ, r8", 0x05, 0x20),
+    FUSED("CP d8 / JR Z, r8", 0xFE, 0x28),
+    FUSED("LD A, (a16) / AND d8", 0xFA, 0xE6)
+};
+
+#undef FUSED
+
+/* True if every entry of the table from index on has a handler, a length of 1 to 3 bytes and a mnemonic */
+constexpr bool cpu::complete_table(const opcode* table, const char* const* mnemonics, quint16 index)
+{
+    return index == 256
+            || (table[index].exec != nullptr && table[index].length >= 1 && table[index].length <= 3
+                && mnemonics[index] != nullptr && complete_table(table, mnemonics, index + 1));
 }
 
-
-
-
 cpu::cpu()
+    : memory(*_MMU)
 {
+    //the tables are built by the compiler, so they are checked by it as well : nothing is left to do here
+    static_assert(complete_table(opcodes_table, opcodes_mnemonics, 0), "opcodes_table is missing entries");
+    static_assert(complete_table(extended_opcodes_table, extended_opcodes_mnemonics, 0), "extended_opcodes_table is missing entries");
+
     //init registers
-    for(quint8 i = 0 ; i < REGISTER_NUMBER ; ++i)
-        R[i] = 0;
+    _AF = 0;
+    _BC = 0;
+    _DE = 0;
+    _HL = 0;
 
-    F  = 0;
+    flags_op = FLAGS_NONE;
     SP = 0;
     PC = 0;
 
@@ -50,493 +722,143 @@ cpu::cpu()
     IME = true;
     last_opcode_not_executed = false;
 
-    //init opcodes
-
     current_opcode = NULL;
+    operand = 0;
+
+#ifdef GB_BLOCK_CACHE
+    for(quint16 i = 0 ; i < BLOCK_CACHE_SIZE ; ++i)
+        blocks[i].count = 0;
+#endif
+}
 
-    //1-byte
-    opcodes_table.insert( 0x00, new opcode("NOP", 1, 4, &cpu::nop) );                           /* 0x00 - NOP */
-    opcodes_table.insert( 0x01, new opcode("LD BC,d16", 3, 12, &cpu::ld_bc_d16) );              /* 0x01 - LD BC, d16 */
-    opcodes_table.insert( 0x02, new opcode("LD (BC),A", 1, 8, &cpu::ld_bc_a) );                 /* 0x02 - LD (BC), A */
-    opcodes_table.insert( 0x03, new opcode("INC BC", 1, 8, &cpu::inc_bc) );                     /* 0x03 - INC BC */
-    opcodes_table.insert( 0x04, new opcode("INC B", 1, 4, &cpu::inc_b) );                       /* 0x04 - INC B */
-    opcodes_table.insert( 0x05, new opcode("DEC B", 1, 4, &cpu::dec_b) );                       /* 0x05 - DEC B */
-    opcodes_table.insert( 0x06, new opcode("LD B,d8", 2, 8, &cpu::ld_b_d8) );                   /* 0x06 - LD B, d8 */
-    opcodes_table.insert( 0x07, new opcode("RLCA", 1, 4, &cpu::rlca) );                         /* 0x07 - RLCA */
-    opcodes_table.insert( 0x08, new opcode("LD (a16), SP", 3, 20, &cpu::ld_a16_sp) );           /* 0x08 - LD (a16), SP */
-    opcodes_table.insert( 0x09, new opcode("ADD HL, BC", 1, 8, &cpu::add_hl_bc) );              /* 0x09 - ADD HL, BC */
-    opcodes_table.insert( 0x0A, new opcode("LD A, (BC)", 1, 8, &cpu::ld_a_bc) );                /* 0x0A - LD A, (BC) */
-    opcodes_table.insert( 0x0B, new opcode("DEC BC", 1, 8, &cpu::dec_bc) );                     /* 0x0B - DEC BC */
-    opcodes_table.insert( 0x0C, new opcode("INC C", 1, 4, &cpu::inc_c) );                       /* 0x0C - INC C */
-    opcodes_table.insert( 0x0D, new opcode("DEC C", 1, 4, &cpu::dec_c) );                       /* 0x0D - DEC C */
-    opcodes_table.insert( 0x0E, new opcode("LD C, d8", 2, 8, &cpu::ld_c_d8) );                  /* 0x0E - LD C, d8 */
-    opcodes_table.insert( 0x0F, new opcode("RRCA", 1, 4, &cpu::rrca) );                         /* 0x0F - RRCA */
-
-    opcodes_table.insert( 0x10, new opcode("STOP 0", 2, 4, &cpu::stop) );                       /* 0x10 - STOP 0 */
-    opcodes_table.insert( 0x11, new opcode("LD DE,d16", 3, 12, &cpu::ld_de_d16) );              /* 0x11 - LD DE, d16 */
-    opcodes_table.insert( 0x12, new opcode("LD (DE),A", 1, 8, &cpu::ld_de_a) );                 /* 0x12 - LD (DE), A */
-    opcodes_table.insert( 0x13, new opcode("INC DE", 1, 8, &cpu::inc_de) );                     /* 0x13 - INC DE */
-    opcodes_table.insert( 0x14, new opcode("INC D", 1, 4, &cpu::inc_d) );                       /* 0x14 - INC D */
-    opcodes_table.insert( 0x15, new opcode("DEC D", 1, 4, &cpu::dec_d) );                       /* 0x15 - DEC D */
-    opcodes_table.insert( 0x16, new opcode("LD D,d8", 2, 8, &cpu::ld_d_d8) );                   /* 0x16 - LD D, d8 */
-    opcodes_table.insert( 0x17, new opcode("RLA", 1, 4, &cpu::rla) );                           /* 0x17 - RLA */
-    opcodes_table.insert( 0x18, new opcode("JR r8", 2, 12, &cpu::jr_r8) );                      /* 0x18 - JR r8 */
-    opcodes_table.insert( 0x19, new opcode("ADD HL, DE", 1, 8, &cpu::add_hl_de) );              /* 0x19 - ADD HL, DE */
-    opcodes_table.insert( 0x1A, new opcode("LD A, (DE)", 1, 8, &cpu::ld_a_de) );                /* 0x1A - LD A, (DE) */
-    opcodes_table.insert( 0x1B, new opcode("DEC DE", 1, 8, &cpu::dec_de) );                     /* 0x1B - DEC DE */
-    opcodes_table.insert( 0x1C, new opcode("INC E", 1, 4, &cpu::inc_e) );                       /* 0x1C - INC E */
-    opcodes_table.insert( 0x1D, new opcode("DEC E", 1, 4, &cpu::dec_e) );                       /* 0x1D - DEC E */
-    opcodes_table.insert( 0x1E, new opcode("LD E, d8", 2, 8, &cpu::ld_e_d8) );                  /* 0x1E - LD E, d8 */
-    opcodes_table.insert( 0x1F, new opcode("RRA", 1, 4, &cpu::rra) );                           /* 0x1F - RRA */
-
-    opcodes_table.insert( 0x20, new opcode("JR NZ,r8", 2, 12, &cpu::jr_nz_r8, 8) );             /* 0x20 - JR NZ, r8 */
-    opcodes_table.insert( 0x21, new opcode("LD HL,d16", 3, 12, &cpu::ld_hl_d16) );              /* 0x21 - LD HL, d16 */
-    opcodes_table.insert( 0x22, new opcode("LDI (HL),A", 1, 8, &cpu::ldi_hl_a) );               /* 0x22 - LDI (HL), A */
-    opcodes_table.insert( 0x23, new opcode("INC HL", 1, 8, &cpu::inc_hl) );                     /* 0x23 - INC HL */
-    opcodes_table.insert( 0x24, new opcode("INC H", 1, 4, &cpu::inc_h) );                       /* 0x24 - INC H */
-    opcodes_table.insert( 0x25, new opcode("DEC H", 1, 4, &cpu::dec_h) );                       /* 0x25 - DEC H */
-    opcodes_table.insert( 0x26, new opcode("LD H,d8", 2, 8, &cpu::ld_h_d8) );                   /* 0x26 - LD H, d8 */
-    opcodes_table.insert( 0x27, new opcode("DAA", 1, 4, &cpu::daa) );                           /* 0x27 - DAA */
-    opcodes_table.insert( 0x28, new opcode("JR Z,r8", 2, 12, &cpu::jr_z_r8, 8) );               /* 0x28 - JR Z, r8 */
-    opcodes_table.insert( 0x29, new opcode("ADD HL, HL", 1, 8, &cpu::add_hl_hl) );              /* 0x29 - ADD HL, HL */
-    opcodes_table.insert( 0x2A, new opcode("LDI A, (HL)", 1, 8, &cpu::ldi_a_hl) );              /* 0x2A - LDI A, (HL) */
-    opcodes_table.insert( 0x2B, new opcode("DEC HL", 1, 8, &cpu::dec_hl) );                     /* 0x2B - DEC HL */
-    opcodes_table.insert( 0x2C, new opcode("INC L", 1, 4, &cpu::inc_l) );                       /* 0x2C - INC L */
-    opcodes_table.insert( 0x2D, new opcode("DEC L", 1, 4, &cpu::dec_l) );                       /* 0x2D - DEC L */
-    opcodes_table.insert( 0x2E, new opcode("LD L, d8", 2, 8, &cpu::ld_l_d8) );                  /* 0x2E - LD L, d8 */
-    opcodes_table.insert( 0x2F, new opcode("CPL", 1, 4, &cpu::cpl) );                           /* 0x2F - CPL */
-
-    opcodes_table.insert( 0x30, new opcode("JR NC,r8", 2, 12, &cpu::jr_nc_r8, 8) );             /* 0x30 - JR NC, r8 */
-    opcodes_table.insert( 0x31, new opcode("LD SP,d16", 3, 12, &cpu::ld_sp_d16) );              /* 0x31 - LD SP, d16 */
-    opcodes_table.insert( 0x32, new opcode("LDD (HL),A", 1, 8, &cpu::ldd_hl_a) );               /* 0x32 - LDD (HL), A */
-    opcodes_table.insert( 0x33, new opcode("INC SP", 1, 8, &cpu::inc_sp) );                     /* 0x33 - INC SP */
-    opcodes_table.insert( 0x34, new opcode("INC (HL)", 1, 12, &cpu::inc_hl_) );                 /* 0x34 - INC (HL) */
-    opcodes_table.insert( 0x35, new opcode("DEC (HL)", 1, 12, &cpu::dec_hl_) );                 /* 0x35 - DEC (HL) */
-    opcodes_table.insert( 0x36, new opcode("LD (HL),d8", 2, 12, &cpu::ld_hl_d8) );              /* 0x36 - LD (HL), d8 */
-    opcodes_table.insert( 0x37, new opcode("SCF", 1, 4, &cpu::scf) );                           /* 0x37 - SCF */
-    opcodes_table.insert( 0x38, new opcode("JR C,r8", 2, 12, &cpu::jr_c_r8, 8) );               /* 0x38 - JR C, r8 */
-    opcodes_table.insert( 0x39, new opcode("ADD HL, SP", 1, 8, &cpu::add_hl_sp) );              /* 0x39 - ADD HL, SP */
-    opcodes_table.insert( 0x3A, new opcode("LDD A, (HL)", 1, 8, &cpu::ldd_a_hl) );              /* 0x3A - LDD A, (HL) */
-    opcodes_table.insert( 0x3B, new opcode("DEC SP", 1, 8, &cpu::dec_sp) );                     /* 0x3B - DEC SP */
-    opcodes_table.insert( 0x3C, new opcode("INC A", 1, 4, &cpu::inc_a) );                       /* 0x3C - INC A */
-    opcodes_table.insert( 0x3D, new opcode("DEC A", 1, 4, &cpu::dec_a) );                       /* 0x3D - DEC A */
-    opcodes_table.insert( 0x3E, new opcode("LD A, d8", 2, 8, &cpu::ld_a_d8) );                  /* 0x3E - LD A, d8 */
-    opcodes_table.insert( 0x3F, new opcode("CCF", 1, 4, &cpu::ccf) );                           /* 0x3F - CCF */
-
-    opcodes_table.insert( 0x40, new opcode("LD B, B", 1, 4, &cpu::ld_b_b) );                    /* 0x40 - LD B, B */
-    opcodes_table.insert( 0x41, new opcode("LD B, C", 1, 4, &cpu::ld_b_c) );                    /* 0x41 - LD B, C */
-    opcodes_table.insert( 0x42, new opcode("LD B, D", 1, 4, &cpu::ld_b_d) );                    /* 0x42 - LD B, D */
-    opcodes_table.insert( 0x43, new opcode("LD B, E", 1, 4, &cpu::ld_b_e) );                    /* 0x43 - LD B, E */
-    opcodes_table.insert( 0x44, new opcode("LD B, H", 1, 4, &cpu::ld_b_h) );                    /* 0x44 - LD B, H */
-    opcodes_table.insert( 0x45, new opcode("LD B, L", 1, 4, &cpu::ld_b_l) );                    /* 0x45 - LD B, L */
-    opcodes_table.insert( 0x46, new opcode("LD B, (HL)", 1, 8, &cpu::ld_b_hl) );                /* 0x46 - LD B, (HL) */
-    opcodes_table.insert( 0x47, new opcode("LD B, A", 1, 4, &cpu::ld_b_a) );                    /* 0x47 - LD B, A */
-    opcodes_table.insert( 0x48, new opcode("LD C, B", 1, 4, &cpu::ld_c_b) );                    /* 0x48 - LD C, B */
-    opcodes_table.insert( 0x49, new opcode("LD C, C", 1, 4, &cpu::ld_c_c) );                    /* 0x49 - LD C, C */
-    opcodes_table.insert( 0x4A, new opcode("LD C, D", 1, 4, &cpu::ld_c_d) );                    /* 0x4A - LD C, D */
-    opcodes_table.insert( 0x4B, new opcode("LD C, E", 1, 4, &cpu::ld_c_e) );                    /* 0x4B - LD C, E */
-    opcodes_table.insert( 0x4C, new opcode("LD C, H", 1, 4, &cpu::ld_c_h) );                    /* 0x4C - LD C, H */
-    opcodes_table.insert( 0x4D, new opcode("LD C, L", 1, 4, &cpu::ld_c_l) );                    /* 0x4D - LD C, L */
-    opcodes_table.insert( 0x4E, new opcode("LD C, (HL)", 1, 8, &cpu::ld_c_hl) );                /* 0x4E - LD C, (HL) */
-    opcodes_table.insert( 0x4F, new opcode("LD C, A", 1, 4, &cpu::ld_c_a) );                    /* 0x4F - LD C, A */
-
-    opcodes_table.insert( 0x50, new opcode("LD D, B", 1, 4, &cpu::ld_d_b) );                    /* 0x50 - LD D, B */
-    opcodes_table.insert( 0x51, new opcode("LD D, C", 1, 4, &cpu::ld_d_c) );                    /* 0x51 - LD D, C */
-    opcodes_table.insert( 0x52, new opcode("LD D, D", 1, 4, &cpu::ld_d_d) );                    /* 0x52 - LD D, D */
-    opcodes_table.insert( 0x53, new opcode("LD D, E", 1, 4, &cpu::ld_d_e) );                    /* 0x53 - LD D, E */
-    opcodes_table.insert( 0x54, new opcode("LD D, H", 1, 4, &cpu::ld_d_h) );                    /* 0x54 - LD D, H */
-    opcodes_table.insert( 0x55, new opcode("LD D, L", 1, 4, &cpu::ld_d_l) );                    /* 0x55 - LD D, L */
-    opcodes_table.insert( 0x56, new opcode("LD D, (HL)", 1, 8, &cpu::ld_d_hl) );                /* 0x56 - LD D, (HL) */
-    opcodes_table.insert( 0x57, new opcode("LD D, A", 1, 4, &cpu::ld_d_a) );                    /* 0x57 - LD D, A */
-    opcodes_table.insert( 0x58, new opcode("LD E, B", 1, 4, &cpu::ld_e_b) );                    /* 0x58 - LD E, B */
-    opcodes_table.insert( 0x59, new opcode("LD E, C", 1, 4, &cpu::ld_e_c) );                    /* 0x59 - LD E, C */
-    opcodes_table.insert( 0x5A, new opcode("LD E, D", 1, 4, &cpu::ld_e_d) );                    /* 0x5A - LD E, D */
-    opcodes_table.insert( 0x5B, new opcode("LD E, E", 1, 4, &cpu::ld_e_e) );                    /* 0x5B - LD E, E */
-    opcodes_table.insert( 0x5C, new opcode("LD E, H", 1, 4, &cpu::ld_e_h) );                    /* 0x5C - LD E, H */
-    opcodes_table.insert( 0x5D, new opcode("LD E, L", 1, 4, &cpu::ld_e_l) );                    /* 0x5D - LD E, L */
-    opcodes_table.insert( 0x5E, new opcode("LD E, (HL)", 1, 8, &cpu::ld_e_hl) );                /* 0x5E - LD E, (HL) */
-    opcodes_table.insert( 0x5F, new opcode("LD E, A", 1, 4, &cpu::ld_e_a) );                    /* 0x5F - LD E, A */
-
-    opcodes_table.insert( 0x60, new opcode("LD H, B", 1, 4, &cpu::ld_h_b) );                    /* 0x60 - LD H, B */
-    opcodes_table.insert( 0x61, new opcode("LD H, C", 1, 4, &cpu::ld_h_c) );                    /* 0x61 - LD H, C */
-    opcodes_table.insert( 0x62, new opcode("LD H, D", 1, 4, &cpu::ld_h_d) );                    /* 0x62 - LD H, D */
-    opcodes_table.insert( 0x63, new opcode("LD H, E", 1, 4, &cpu::ld_h_e) );                    /* 0x63 - LD H, E */
-    opcodes_table.insert( 0x64, new opcode("LD H, H", 1, 4, &cpu::ld_h_h) );                    /* 0x64 - LD H, H */
-    opcodes_table.insert( 0x65, new opcode("LD H, L", 1, 4, &cpu::ld_h_l) );                    /* 0x65 - LD H, L */
-    opcodes_table.insert( 0x66, new opcode("LD H, (HL)", 1, 8, &cpu::ld_h_hl) );                /* 0x66 - LD H, (HL) */
-    opcodes_table.insert( 0x67, new opcode("LD H, A", 1, 4, &cpu::ld_h_a) );                    /* 0x67 - LD H, A */
-    opcodes_table.insert( 0x68, new opcode("LD L, B", 1, 4, &cpu::ld_l_b) );                    /* 0x68 - LD L, B */
-    opcodes_table.insert( 0x69, new opcode("LD L, C", 1, 4, &cpu::ld_l_c) );                    /* 0x69 - LD L, C */
-    opcodes_table.insert( 0x6A, new opcode("LD L, D", 1, 4, &cpu::ld_l_d) );                    /* 0x6A - LD L, D */
-    opcodes_table.insert( 0x6B, new opcode("LD L, E", 1, 4, &cpu::ld_l_e) );                    /* 0x6B - LD L, E */
-    opcodes_table.insert( 0x6C, new opcode("LD L, H", 1, 4, &cpu::ld_l_h) );                    /* 0x6C - LD L, H */
-    opcodes_table.insert( 0x6D, new opcode("LD L, L", 1, 4, &cpu::ld_l_l) );                    /* 0x6D - LD L, L */
-    opcodes_table.insert( 0x6E, new opcode("LD L, (HL)", 1, 8, &cpu::ld_l_hl) );                /* 0x6E - LD L, (HL) */
-    opcodes_table.insert( 0x6F, new opcode("LD L, A", 1, 4, &cpu::ld_l_a) );                    /* 0x6F - LD L, A */
-
-    opcodes_table.insert( 0x70, new opcode("LD (HL), B", 1, 8, &cpu::ld_hl_b) );                /* 0x70 - LD (HL), B */
-    opcodes_table.insert( 0x71, new opcode("LD (HL), C", 1, 8, &cpu::ld_hl_c) );                /* 0x71 - LD (HL), C */
-    opcodes_table.insert( 0x72, new opcode("LD (HL), D", 1, 8, &cpu::ld_hl_d) );                /* 0x72 - LD (HL), D */
-    opcodes_table.insert( 0x73, new opcode("LD (HL), E", 1, 8, &cpu::ld_hl_e) );                /* 0x73 - LD (HL), E */
-    opcodes_table.insert( 0x74, new opcode("LD (HL), H", 1, 8, &cpu::ld_hl_h) );                /* 0x74 - LD (HL), H */
-    opcodes_table.insert( 0x75, new opcode("LD (HL), L", 1, 8, &cpu::ld_hl_l) );                /* 0x75 - LD (HL), L */
-    opcodes_table.insert( 0x76, new opcode("HALT", 1, 4, &cpu::halt) );                         /* 0x76 - HALT */
-    opcodes_table.insert( 0x77, new opcode("LD (HL), A", 1, 8, &cpu::ld_hl_a) );                /* 0x77 - LD (HL), A */
-    opcodes_table.insert( 0x78, new opcode("LD A, B", 1, 4, &cpu::ld_a_b) );                    /* 0x78 - LD A, B */
-    opcodes_table.insert( 0x79, new opcode("LD A, C", 1, 4, &cpu::ld_a_c) );                    /* 0x79 - LD A, C */
-    opcodes_table.insert( 0x7A, new opcode("LD A, D", 1, 4, &cpu::ld_a_d) );                    /* 0x7A - LD A, D */
-    opcodes_table.insert( 0x7B, new opcode("LD A, E", 1, 4, &cpu::ld_a_e) );                    /* 0x7B - LD A, E */
-    opcodes_table.insert( 0x7C, new opcode("LD A, H", 1, 4, &cpu::ld_a_h) );                    /* 0x7C - LD A, H */
-    opcodes_table.insert( 0x7D, new opcode("LD A, L", 1, 4, &cpu::ld_a_l) );                    /* 0x7D - LD A, L */
-    opcodes_table.insert( 0x7E, new opcode("LD A, (HL)", 1, 8, &cpu::ld_a_hl) );                /* 0x7E - LD A, (HL) */
-    opcodes_table.insert( 0x7F, new opcode("LD A, A", 1, 4, &cpu::ld_a_a) );                    /* 0x7F - LD A, A */
-
-    opcodes_table.insert( 0x80, new opcode("ADD A, B", 1, 4, &cpu::add_a_b) );                  /* 0x80 - ADD A, B */
-    opcodes_table.insert( 0x81, new opcode("ADD A, C", 1, 4, &cpu::add_a_c) );                  /* 0x81 - ADD A, C */
-    opcodes_table.insert( 0x82, new opcode("ADD A, D", 1, 4, &cpu::add_a_d) );                  /* 0x82 - ADD A, D */
-    opcodes_table.insert( 0x83, new opcode("ADD A, E", 1, 4, &cpu::add_a_e) );                  /* 0x83 - ADD A, E */
-    opcodes_table.insert( 0x84, new opcode("ADD A, H", 1, 4, &cpu::add_a_h) );                  /* 0x84 - ADD A, H */
-    opcodes_table.insert( 0x85, new opcode("ADD A, L", 1, 4, &cpu::add_a_l) );                  /* 0x85 - ADD A, L */
-    opcodes_table.insert( 0x86, new opcode("ADD A, (HL)", 1, 8, &cpu::add_a_hl) );              /* 0x86 - ADD A, (HL) */
-    opcodes_table.insert( 0x87, new opcode("ADD A, A", 1, 4, &cpu::add_a_a) );                  /* 0x87 - ADD A, A */
-    opcodes_table.insert( 0x88, new opcode("ADC A, B", 1, 4, &cpu::adc_a_b) );                  /* 0x88 - ADC A, B */
-    opcodes_table.insert( 0x89, new opcode("ADC A, C", 1, 4, &cpu::adc_a_c) );                  /* 0x89 - ADC A, C */
-    opcodes_table.insert( 0x8A, new opcode("ADC A, D", 1, 4, &cpu::adc_a_d) );                  /* 0x8A - ADC A, D */
-    opcodes_table.insert( 0x8B, new opcode("ADC A, E", 1, 4, &cpu::adc_a_e) );                  /* 0x8B - ADC A, E */
-    opcodes_table.insert( 0x8C, new opcode("ADC A, H", 1, 4, &cpu::adc_a_h) );                  /* 0x8C - ADC A, H */
-    opcodes_table.insert( 0x8D, new opcode("ADC A, L", 1, 4, &cpu::adc_a_l) );                  /* 0x8D - ADC A, L */
-    opcodes_table.insert( 0x8E, new opcode("ADC A, (HL)", 1, 8, &cpu::adc_a_hl) );              /* 0x8E - ADC A, (HL) */
-    opcodes_table.insert( 0x8F, new opcode("ADC A, A", 1, 4, &cpu::adc_a_a) );                  /* 0x8F - ADC A, A */
-
-    opcodes_table.insert( 0x90, new opcode("SUB B", 1, 4, &cpu::sub_b) );                       /* 0x90 - SUB B */
-    opcodes_table.insert( 0x91, new opcode("SUB C", 1, 4, &cpu::sub_c) );                       /* 0x91 - SUB C */
-    opcodes_table.insert( 0x92, new opcode("SUB D", 1, 4, &cpu::sub_d) );                       /* 0x92 - SUB D */
-    opcodes_table.insert( 0x93, new opcode("SUB E", 1, 4, &cpu::sub_e) );                       /* 0x93 - SUB E */
-    opcodes_table.insert( 0x94, new opcode("SUB H", 1, 4, &cpu::sub_h) );                       /* 0x94 - SUB H */
-    opcodes_table.insert( 0x95, new opcode("SUB L", 1, 4, &cpu::sub_l) );                       /* 0x95 - SUB L */
-    opcodes_table.insert( 0x96, new opcode("SUB (HL)", 1, 8, &cpu::sub_hl) );                   /* 0x96 - SUB (HL) */
-    opcodes_table.insert( 0x97, new opcode("SUB A", 1, 4, &cpu::sub_a) );                       /* 0x97 - SUB A */
-    opcodes_table.insert( 0x98, new opcode("SBC A, B", 1, 4, &cpu::sbc_a_b) );                  /* 0x98 - SBC A, B */
-    opcodes_table.insert( 0x99, new opcode("SBC A, C", 1, 4, &cpu::sbc_a_c) );                  /* 0x99 - SBC A, C */
-    opcodes_table.insert( 0x9A, new opcode("SBC A, D", 1, 4, &cpu::sbc_a_d) );                  /* 0x9A - SBC A, D */
-    opcodes_table.insert( 0x9B, new opcode("SBC A, E", 1, 4, &cpu::sbc_a_e) );                  /* 0x9B - SBC A, E */
-    opcodes_table.insert( 0x9C, new opcode("SBC A, H", 1, 4, &cpu::sbc_a_h) );                  /* 0x9C - SBC A, H */
-    opcodes_table.insert( 0x9D, new opcode("SBC A, L", 1, 4, &cpu::sbc_a_l) );                  /* 0x9D - SBC A, L */
-    opcodes_table.insert( 0x9E, new opcode("SBC A, (HL)", 1, 8, &cpu::sbc_a_hl) );              /* 0x9E - SBC A, (HL) */
-    opcodes_table.insert( 0x9F, new opcode("SBC A, A", 1, 4, &cpu::sbc_a_a) );                  /* 0x9F - SBC A, A */
-
-    opcodes_table.insert( 0xA0, new opcode("AND B", 1, 4, &cpu::and_b) );                       /* 0xA0 - AND B */
-    opcodes_table.insert( 0xA1, new opcode("AND C", 1, 4, &cpu::and_c) );                       /* 0xA1 - AND C */
-    opcodes_table.insert( 0xA2, new opcode("AND D", 1, 4, &cpu::and_d) );                       /* 0xA2 - AND D */
-    opcodes_table.insert( 0xA3, new opcode("AND E", 1, 4, &cpu::and_e) );                       /* 0xA3 - AND E */
-    opcodes_table.insert( 0xA4, new opcode("AND H", 1, 4, &cpu::and_h) );                       /* 0xA4 - AND H */
-    opcodes_table.insert( 0xA5, new opcode("AND L", 1, 4, &cpu::and_l) );                       /* 0xA5 - AND L */
-    opcodes_table.insert( 0xA6, new opcode("AND (HL)", 1, 8, &cpu::and_hl) );                   /* 0xA6 - AND (HL) */
-    opcodes_table.insert( 0xA7, new opcode("AND A", 1, 4, &cpu::and_a) );                       /* 0xA7 - AND A */
-    opcodes_table.insert( 0xA8, new opcode("XOR B", 1, 4, &cpu::xor_b) );                       /* 0xA8 - XOR B */
-    opcodes_table.insert( 0xA9, new opcode("XOR C", 1, 4, &cpu::xor_c) );                       /* 0xA9 - XOR C */
-    opcodes_table.insert( 0xAA, new opcode("XOR D", 1, 4, &cpu::xor_d) );                       /* 0xAA - XOR D */
-    opcodes_table.insert( 0xAB, new opcode("XOR E", 1, 4, &cpu::xor_e) );                       /* 0xAB - XOR E */
-    opcodes_table.insert( 0xAC, new opcode("XOR H", 1, 4, &cpu::xor_h) );                       /* 0xAC - XOR H */
-    opcodes_table.insert( 0xAD, new opcode("XOR L", 1, 4, &cpu::xor_l) );                       /* 0xAD - XOR L */
-    opcodes_table.insert( 0xAE, new opcode("XOR (HL)", 1, 8, &cpu::xor_hl) );                   /* 0xAE - XOR (HL) */
-    opcodes_table.insert( 0xAF, new opcode("XOR A", 1, 4, &cpu::xor_a) );                       /* 0xAF - XOR A */
-
-    opcodes_table.insert( 0xB0, new opcode("OR B", 1, 4, &cpu::or_b) );                         /* 0xB0 - OR B */
-    opcodes_table.insert( 0xB1, new opcode("OR C", 1, 4, &cpu::or_c) );                         /* 0xB1 - OR C */
-    opcodes_table.insert( 0xB2, new opcode("OR D", 1, 4, &cpu::or_d) );                         /* 0xB2 - OR D */
-    opcodes_table.insert( 0xB3, new opcode("OR E", 1, 4, &cpu::or_e) );                         /* 0xB3 - OR E */
-    opcodes_table.insert( 0xB4, new opcode("OR H", 1, 4, &cpu::or_h) );                         /* 0xB4 - OR H */
-    opcodes_table.insert( 0xB5, new opcode("OR L", 1, 4, &cpu::or_l) );                         /* 0xB5 - OR L */
-    opcodes_table.insert( 0xB6, new opcode("OR (HL)", 1, 8, &cpu::or_hl) );                     /* 0xB6 - OR (HL) */
-    opcodes_table.insert( 0xB7, new opcode("OR A", 1, 4, &cpu::or_a) );                         /* 0xB7 - OR A */
-    opcodes_table.insert( 0xB8, new opcode("CP B", 1, 4, &cpu::cp_b) );                         /* 0xB8 - CP B */
-    opcodes_table.insert( 0xB9, new opcode("CP C", 1, 4, &cpu::cp_c) );                         /* 0xB9 - CP C */
-    opcodes_table.insert( 0xBA, new opcode("CP D", 1, 4, &cpu::cp_d) );                         /* 0xBA - CP D */
-    opcodes_table.insert( 0xBB, new opcode("CP E", 1, 4, &cpu::cp_e) );                         /* 0xBB - CP E */
-    opcodes_table.insert( 0xBC, new opcode("CP H", 1, 4, &cpu::cp_h) );                         /* 0xBC - CP H */
-    opcodes_table.insert( 0xBD, new opcode("CP L", 1, 4, &cpu::cp_l) );                         /* 0xBD - CP L */
-    opcodes_table.insert( 0xBE, new opcode("CP (HL)", 1, 8, &cpu::cp_hl) );                     /* 0xBE - CP (HL) */
-    opcodes_table.insert( 0xBF, new opcode("CP A", 1, 4, &cpu::cp_a) );                         /* 0xBF - CP A */
-
-    opcodes_table.insert( 0xC0, new opcode("RET NZ", 1, 20, &cpu::ret_nz, 8) );                 /* 0xC0 - RET NZ */
-    opcodes_table.insert( 0xC1, new opcode("POP BC", 1, 12, &cpu::pop_bc) );                    /* 0xC1 - POP BC */
-    opcodes_table.insert( 0xC2, new opcode("JP NZ, a16", 3, 16, &cpu::jp_nz_a16, 12) );         /* 0xC2 - JP NZ, a16 */
-    opcodes_table.insert( 0xC3, new opcode("JP a16", 3, 16, &cpu::jp_a16) );                    /* 0xC3 - JP a16 */
-    opcodes_table.insert( 0xC4, new opcode("CALL NZ, a16", 3, 24, &cpu::call_nz_a16, 12) );     /* 0xC4 - CALL NZ, a16 */
-    opcodes_table.insert( 0xC5, new opcode("PUSH BC", 1, 16, &cpu::push_bc) );                  /* 0xC5 - PUSH BC */
-    opcodes_table.insert( 0xC6, new opcode("ADD A, d8", 2, 8, &cpu::add_a_d8) );                /* 0xC6 - ADD A, d8 */
-    opcodes_table.insert( 0xC7, new opcode("RST 00h", 1, 16, &cpu::rst_00h) );                  /* 0xC7 - RST 00h */
-    opcodes_table.insert( 0xC8, new opcode("RET Z", 1, 20, &cpu::ret_z, 8) );                   /* 0xC8 - RET Z */
-    opcodes_table.insert( 0xC9, new opcode("RET", 1, 16, &cpu::ret) );                          /* 0xC9 - RET */
-    opcodes_table.insert( 0xCA, new opcode("JP Z, a16", 3, 16, &cpu::jp_z_a16, 12) );           /* 0xCA - JP Z, a16 */
-    opcodes_table.insert( 0xCB, new opcode("PREFIX CB", 1, 4, &cpu::prefix_cb) );               /* 0xCB - PREFIX CB */
-    opcodes_table.insert( 0xCC, new opcode("CALL Z, a16", 3, 24, &cpu::call_z_a16, 12) );       /* 0xCC - CALL Z, a16 */
-    opcodes_table.insert( 0xCD, new opcode("CALL a16", 3, 24, &cpu::call_a16) );                /* 0xCD - CALL a16 */
-    opcodes_table.insert( 0xCE, new opcode("ADC A, d8", 2, 8, &cpu::adc_a_d8) );                /* 0xCE - ADC A, d8 */
-    opcodes_table.insert( 0xCF, new opcode("RST 08h", 1, 16, &cpu::rst_08h) );                  /* 0xCF - RST 08h */
-
-    opcodes_table.insert( 0xD0, new opcode("RET NC", 1, 20, &cpu::ret_nc, 8) );                 /* 0xD0 - RET NC */
-    opcodes_table.insert( 0xD1, new opcode("POP DE", 1, 12, &cpu::pop_de) );                    /* 0xD1 - POP DE */
-    opcodes_table.insert( 0xD2, new opcode("JP NC, a16", 3, 16, &cpu::jp_nc_a16, 12) );         /* 0xD2 - JP NC, a16 */
-    opcodes_table.insert( 0xD3, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xD3 - NOT IMPL */
-    opcodes_table.insert( 0xD4, new opcode("CALL NC, a16", 3, 24, &cpu::call_nc_a16, 12) );     /* 0xD4 - CALL NC, a16 */
-    opcodes_table.insert( 0xD5, new opcode("PUSH DE", 1, 16, &cpu::push_de) );                  /* 0xD5 - PUSH DE */
-    opcodes_table.insert( 0xD6, new opcode("SUB d8", 2, 8, &cpu::sub_d8) );                     /* 0xD6 - SUB d8 */
-    opcodes_table.insert( 0xD7, new opcode("RST 10h", 1, 16, &cpu::rst_10h) );                  /* 0xD7 - RST 10h */
-    opcodes_table.insert( 0xD8, new opcode("RET C", 1, 20, &cpu::ret_c, 8) );                   /* 0xD8 - RET C */
-    opcodes_table.insert( 0xD9, new opcode("RETI", 1, 16, &cpu::reti) );                        /* 0xD9 - RETI */
-    opcodes_table.insert( 0xDA, new opcode("JP C, a16", 3, 16, &cpu::jp_c_a16, 12) );           /* 0xDA - JP C, a16 */
-    opcodes_table.insert( 0xDB, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xDB - NOT IMPL */
-    opcodes_table.insert( 0xDC, new opcode("CALL C, a16", 3, 24, &cpu::call_c_a16, 12) );       /* 0xDC - CALL C, a16 */
-    opcodes_table.insert( 0xDD, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xDD - NOT IMPL */
-    opcodes_table.insert( 0xDE, new opcode("SBC A, d8", 2, 8, &cpu::sbc_a_d8) );                /* 0xDE - SBC A, d8 */
-    opcodes_table.insert( 0xDF, new opcode("RST 18h", 1, 16, &cpu::rst_18h) );                  /* 0xDF - RST 18h */
-
-    opcodes_table.insert( 0xE0, new opcode("LDH (a8), A", 2, 12, &cpu::ldh_a8_a) );             /* 0xE0 - LDH (a8), A */
-    opcodes_table.insert( 0xE1, new opcode("POP HL", 1, 12, &cpu::pop_hl) );                    /* 0xE1 - POP HL */
-    opcodes_table.insert( 0xE2, new opcode("LD (C), A", 2, 8, &cpu::ld_c_a_) );                 /* 0xE2 - LD (C), A */
-    opcodes_table.insert( 0xE3, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xE3 - NOT IMPL */
-    opcodes_table.insert( 0xE4, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xE4 - NOT IMPL */
-    opcodes_table.insert( 0xE5, new opcode("PUSH HL", 1, 16, &cpu::push_hl) );                  /* 0xE5 - PUSH HL */
-    opcodes_table.insert( 0xE6, new opcode("AND d8", 2, 8, &cpu::and_d8) );                     /* 0xE6 - AND d8 */
-    opcodes_table.insert( 0xE7, new opcode("RST 20h", 1, 16, &cpu::rst_20h) );                  /* 0xE7 - RST 20h */
-    opcodes_table.insert( 0xE8, new opcode("ADD SP, r8", 2, 16, &cpu::add_sp_r8) );             /* 0xE8 - ADD SP, r8 */
-    opcodes_table.insert( 0xE9, new opcode("JP (HL)", 1, 4, &cpu::jp_hl) );                     /* 0xE9 - JP (HL) */
-    opcodes_table.insert( 0xEA, new opcode("LD (a16), A", 3, 16, &cpu::ld_a16_a) );             /* 0xEA - LD (a16), A */
-    opcodes_table.insert( 0xEB, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xEB - NOT IMPL */
-    opcodes_table.insert( 0xEC, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xEC - NOT IMPL */
-    opcodes_table.insert( 0xED, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xED - NOT IMPL */
-    opcodes_table.insert( 0xEE, new opcode("XOR d8", 2, 8, &cpu::xor_d8) );                     /* 0xEE - XOR d8 */
-    opcodes_table.insert( 0xEF, new opcode("RST 28h", 1, 16, &cpu::rst_28h) );                  /* 0xEF - RST 28h */
-
-    opcodes_table.insert( 0xF0, new opcode("LDH A, (a8)", 2, 12, &cpu::ldh_a_a8) );             /* 0xF0 - LDH A, (a8) */
-    opcodes_table.insert( 0xF1, new opcode("POP AF", 1, 12, &cpu::pop_af) );                    /* 0xF1 - POP AF */
-    opcodes_table.insert( 0xF2, new opcode("LD A, (C)", 2, 8, &cpu::ld_a_c_) );                 /* 0xF2 - LD A, (C) */
-    opcodes_table.insert( 0xF3, new opcode("DI", 1, 4, &cpu::di) );                             /* 0xF3 - DI */
-    opcodes_table.insert( 0xF4, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xF4 - NOT IMPL */
-    opcodes_table.insert( 0xF5, new opcode("PUSH AF", 1, 16, &cpu::push_af) );                  /* 0xF5 - PUSH AF */
-    opcodes_table.insert( 0xF6, new opcode("OR d8", 2, 8, &cpu::or_d8) );                       /* 0xF6 - OR d8 */
-    opcodes_table.insert( 0xF7, new opcode("RST 30h", 1, 16, &cpu::rst_30h) );                  /* 0xF7 - RST 30h */
-    opcodes_table.insert( 0xF8, new opcode("LDHL SP, r8", 2, 12, &cpu::ldhl_sp_r8) );           /* 0xF8 - LDHL SP, r8 */
-    opcodes_table.insert( 0xF9, new opcode("LD SP, HL", 1, 8, &cpu::ld_sp_hl) );                /* 0xF9 - LD SP, HL */
-    opcodes_table.insert( 0xFA, new opcode("LD A, (a16)", 3, 16, &cpu::ld_a_a16) );             /* 0xFA - LD A, (a16) */
-    opcodes_table.insert( 0xFB, new opcode("EI", 1, 4, &cpu::ei) );                             /* 0xFB - EI */
-    opcodes_table.insert( 0xFC, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xFC - NOT IMPL */
-    opcodes_table.insert( 0xFD, new opcode("NOT IMPL", 1, 1, &cpu::not_impl) );                 /* 0xFD - NOT IMPL */
-    opcodes_table.insert( 0xFE, new opcode("CP d8", 2, 8, &cpu::cp_d8) );                       /* 0xFE - CP d8 */
-    opcodes_table.insert( 0xFF, new opcode("RST 38h", 1, 16, &cpu::rst_38h) );                  /* 0xFF - RST 38h */
-
-    //2 bytes-opcodes
-    extended_opcodes_table.insert( 0x00, new opcode("RLC B", 2, 8, &cpu::rlc_b));               /* 0xCB00 - RLC B */
-    extended_opcodes_table.insert( 0x01, new opcode("RLC C", 2, 8, &cpu::rlc_c));               /* 0xCB01 - RLC C */
-    extended_opcodes_table.insert( 0x02, new opcode("RLC D", 2, 8, &cpu::rlc_d));               /* 0xCB02 - RLC D */
-    extended_opcodes_table.insert( 0x03, new opcode("RLC E", 2, 8, &cpu::rlc_e));               /* 0xCB03 - RLC E */
-    extended_opcodes_table.insert( 0x04, new opcode("RLC H", 2, 8, &cpu::rlc_h));               /* 0xCB04 - RLC H */
-    extended_opcodes_table.insert( 0x05, new opcode("RLC L", 2, 8, &cpu::rlc_l));               /* 0xCB05 - RLC L */
-    extended_opcodes_table.insert( 0x06, new opcode("RLC (HL)", 2, 16, &cpu::rlc_hl));          /* 0xCB06 - RLC (HL) */
-    extended_opcodes_table.insert( 0x07, new opcode("RLC A", 2, 8, &cpu::rlc_a));               /* 0xCB07 - RLC A */
-    extended_opcodes_table.insert( 0x08, new opcode("RRC B", 2, 8, &cpu::rrc_b));               /* 0xCB08 - RRC B */
-    extended_opcodes_table.insert( 0x09, new opcode("RRC C", 2, 8, &cpu::rrc_c));               /* 0xCB09 - RRC C */
-    extended_opcodes_table.insert( 0x0A, new opcode("RRC D", 2, 8, &cpu::rrc_d));               /* 0xCB0A - RRC D */
-    extended_opcodes_table.insert( 0x0B, new opcode("RRC E", 2, 8, &cpu::rrc_e));               /* 0xCB0B - RRC E */
-    extended_opcodes_table.insert( 0x0C, new opcode("RRC H", 2, 8, &cpu::rrc_h));               /* 0xCB0C - RRC H */
-    extended_opcodes_table.insert( 0x0D, new opcode("RRC L", 2, 8, &cpu::rrc_l));               /* 0xCB0D - RRC L */
-    extended_opcodes_table.insert( 0x0E, new opcode("RRC (HL)", 2, 16, &cpu::rrc_hl));          /* 0xCB0E - RRC (HL) */
-    extended_opcodes_table.insert( 0x0F, new opcode("RRC A", 2, 8, &cpu::rrc_a));               /* 0xCB0F - RRC A */
-
-    extended_opcodes_table.insert( 0x10, new opcode("RL B", 2, 8, &cpu::rl_b));                 /* 0xCB10 - RL B */
-    extended_opcodes_table.insert( 0x11, new opcode("RL C", 2, 8, &cpu::rl_c));                 /* 0xCB11 - RL C */
-    extended_opcodes_table.insert( 0x12, new opcode("RL D", 2, 8, &cpu::rl_d));                 /* 0xCB12 - RL D */
-    extended_opcodes_table.insert( 0x13, new opcode("RL E", 2, 8, &cpu::rl_e));                 /* 0xCB13 - RL E */
-    extended_opcodes_table.insert( 0x14, new opcode("RL H", 2, 8, &cpu::rl_h));                 /* 0xCB14 - RL H */
-    extended_opcodes_table.insert( 0x15, new opcode("RL L", 2, 8, &cpu::rl_l));                 /* 0xCB15 - RL L */
-    extended_opcodes_table.insert( 0x16, new opcode("RL (HL)", 2, 16, &cpu::rl_hl));            /* 0xCB16 - RL (HL) */
-    extended_opcodes_table.insert( 0x17, new opcode("RL A", 2, 8, &cpu::rl_a));                 /* 0xCB17 - RL A */
-    extended_opcodes_table.insert( 0x18, new opcode("RR B", 2, 8, &cpu::rr_b));                 /* 0xCB18 - RR B */
-    extended_opcodes_table.insert( 0x19, new opcode("RR C", 2, 8, &cpu::rr_c));                 /* 0xCB19 - RR C */
-    extended_opcodes_table.insert( 0x1A, new opcode("RR D", 2, 8, &cpu::rr_d));                 /* 0xCB1A - RR D */
-    extended_opcodes_table.insert( 0x1B, new opcode("RR E", 2, 8, &cpu::rr_e));                 /* 0xCB1B - RR E */
-    extended_opcodes_table.insert( 0x1C, new opcode("RR H", 2, 8, &cpu::rr_h));                 /* 0xCB1C - RR H */
-    extended_opcodes_table.insert( 0x1D, new opcode("RR L", 2, 8, &cpu::rr_l));                 /* 0xCB1D - RR L */
-    extended_opcodes_table.insert( 0x1E, new opcode("RR (HL)", 2, 16, &cpu::rr_hl));            /* 0xCB1E - RR (HL) */
-    extended_opcodes_table.insert( 0x1F, new opcode("RR A", 2, 8, &cpu::rr_a));                 /* 0xCB1F - RR A */
-
-    extended_opcodes_table.insert( 0x20, new opcode("SLA B", 2, 8, &cpu::sla_b));               /* 0xCB20 - SLA B */
-    extended_opcodes_table.insert( 0x21, new opcode("SLA C", 2, 8, &cpu::sla_c));               /* 0xCB21 - SLA C */
-    extended_opcodes_table.insert( 0x22, new opcode("SLA D", 2, 8, &cpu::sla_d));               /* 0xCB22 - SLA D */
-    extended_opcodes_table.insert( 0x23, new opcode("SLA E", 2, 8, &cpu::sla_e));               /* 0xCB23 - SLA E */
-    extended_opcodes_table.insert( 0x24, new opcode("SLA H", 2, 8, &cpu::sla_h));               /* 0xCB24 - SLA H */
-    extended_opcodes_table.insert( 0x25, new opcode("SLA L", 2, 8, &cpu::sla_l));               /* 0xCB25 - SLA L */
-    extended_opcodes_table.insert( 0x26, new opcode("SLA (HL)", 2, 16, &cpu::sla_hl));          /* 0xCB26 - SLA (HL) */
-    extended_opcodes_table.insert( 0x27, new opcode("SLA A", 2, 8, &cpu::sla_a));               /* 0xCB27 - SLA A */
-    extended_opcodes_table.insert( 0x28, new opcode("SRA B", 2, 8, &cpu::sra_b));               /* 0xCB28 - SRA B */
-    extended_opcodes_table.insert( 0x29, new opcode("SRA C", 2, 8, &cpu::sra_c));               /* 0xCB29 - SRA C */
-    extended_opcodes_table.insert( 0x2A, new opcode("SRA D", 2, 8, &cpu::sra_d));               /* 0xCB2A - SRA D */
-    extended_opcodes_table.insert( 0x2B, new opcode("SRA E", 2, 8, &cpu::sra_e));               /* 0xCB2B - SRA E */
-    extended_opcodes_table.insert( 0x2C, new opcode("SRA H", 2, 8, &cpu::sra_h));               /* 0xCB2C - SRA H */
-    extended_opcodes_table.insert( 0x2D, new opcode("SRA L", 2, 8, &cpu::sra_l));               /* 0xCB2D - SRA L */
-    extended_opcodes_table.insert( 0x2E, new opcode("SRA (HL)", 2, 16, &cpu::sra_hl));          /* 0xCB2E - SRA (HL) */
-    extended_opcodes_table.insert( 0x2F, new opcode("SRA A", 2, 8, &cpu::sra_a));               /* 0xCB2F - SRA A */
-
-    extended_opcodes_table.insert( 0x30, new opcode("SWAP B", 2, 8, &cpu::swap_b));             /* 0xCB30 - SWAP B */
-    extended_opcodes_table.insert( 0x31, new opcode("SWAP C", 2, 8, &cpu::swap_c));             /* 0xCB31 - SWAP C */
-    extended_opcodes_table.insert( 0x32, new opcode("SWAP D", 2, 8, &cpu::swap_d));             /* 0xCB32 - SWAP D */
-    extended_opcodes_table.insert( 0x33, new opcode("SWAP E", 2, 8, &cpu::swap_e));             /* 0xCB33 - SWAP E */
-    extended_opcodes_table.insert( 0x34, new opcode("SWAP H", 2, 8, &cpu::swap_h));             /* 0xCB34 - SWAP H */
-    extended_opcodes_table.insert( 0x35, new opcode("SWAP L", 2, 8, &cpu::swap_l));             /* 0xCB35 - SWAP L */
-    extended_opcodes_table.insert( 0x36, new opcode("SWAP (HL)", 2, 16, &cpu::swap_hl));        /* 0xCB36 - SWAP (HL) */
-    extended_opcodes_table.insert( 0x37, new opcode("SWAP A", 2, 8, &cpu::swap_a));             /* 0xCB37 - SWAP A */
-    extended_opcodes_table.insert( 0x38, new opcode("SRL B", 2, 8, &cpu::srl_b));               /* 0xCB38 - SRL B */
-    extended_opcodes_table.insert( 0x39, new opcode("SRL C", 2, 8, &cpu::srl_c));               /* 0xCB39 - SRL C */
-    extended_opcodes_table.insert( 0x3A, new opcode("SRL D", 2, 8, &cpu::srl_d));               /* 0xCB3A - SRL D */
-    extended_opcodes_table.insert( 0x3B, new opcode("SRL E", 2, 8, &cpu::srl_e));               /* 0xCB3B - SRL E */
-    extended_opcodes_table.insert( 0x3C, new opcode("SRL H", 2, 8, &cpu::srl_h));               /* 0xCB3C - SRL H */
-    extended_opcodes_table.insert( 0x3D, new opcode("SRL L", 2, 8, &cpu::srl_l));               /* 0xCB3D - SRL L */
-    extended_opcodes_table.insert( 0x3E, new opcode("SRL (HL)", 2, 16, &cpu::srl_hl));          /* 0xCB3E - SRL (HL) */
-    extended_opcodes_table.insert( 0x3F, new opcode("SRL A", 2, 8, &cpu::srl_a));               /* 0xCB3F - SRL A */
-
-    extended_opcodes_table.insert( 0x40, new opcode("BIT 0, B", 2, 8, &cpu::bit_0_b));          /* 0xCB40 - BIT 0, B */
-    extended_opcodes_table.insert( 0x41, new opcode("BIT 0, C", 2, 8, &cpu::bit_0_c));          /* 0xCB41 - BIT 0, C */
-    extended_opcodes_table.insert( 0x42, new opcode("BIT 0, D", 2, 8, &cpu::bit_0_d));          /* 0xCB42 - BIT 0, D */
-    extended_opcodes_table.insert( 0x43, new opcode("BIT 0, E", 2, 8, &cpu::bit_0_e));          /* 0xCB43 - BIT 0, E */
-    extended_opcodes_table.insert( 0x44, new opcode("BIT 0, H", 2, 8, &cpu::bit_0_h));          /* 0xCB44 - BIT 0, H */
-    extended_opcodes_table.insert( 0x45, new opcode("BIT 0, L", 2, 8, &cpu::bit_0_l));          /* 0xCB45 - BIT 0, L */
-    extended_opcodes_table.insert( 0x46, new opcode("BIT 0, (HL)", 2, 16, &cpu::bit_0_hl));     /* 0xCB46 - BIT 0, (HL) */
-    extended_opcodes_table.insert( 0x47, new opcode("BIT 0, A", 2, 8, &cpu::bit_0_a));          /* 0xCB47 - BIT 0, A */
-    extended_opcodes_table.insert( 0x48, new opcode("BIT 1, B", 2, 8, &cpu::bit_1_b));          /* 0xCB48 - BIT 1, B */
-    extended_opcodes_table.insert( 0x49, new opcode("BIT 1, C", 2, 8, &cpu::bit_1_c));          /* 0xCB49 - BIT 1, C */
-    extended_opcodes_table.insert( 0x4A, new opcode("BIT 1, D", 2, 8, &cpu::bit_1_d));          /* 0xCB4A - BIT 1, D */
-    extended_opcodes_table.insert( 0x4B, new opcode("BIT 1, E", 2, 8, &cpu::bit_1_e));          /* 0xCB4B - BIT 1, E */
-    extended_opcodes_table.insert( 0x4C, new opcode("BIT 1, H", 2, 8, &cpu::bit_1_h));          /* 0xCB4C - BIT 1, H */
-    extended_opcodes_table.insert( 0x4D, new opcode("BIT 1, L", 2, 8, &cpu::bit_1_l));          /* 0xCB4D - BIT 1, L */
-    extended_opcodes_table.insert( 0x4E, new opcode("BIT 1, (HL)", 2, 16, &cpu::bit_1_hl));     /* 0xCB4E - BIT 1, (HL) */
-    extended_opcodes_table.insert( 0x4F, new opcode("BIT 1, A", 2, 8, &cpu::bit_1_a));          /* 0xCB4F - BIT 1, A */
-
-    extended_opcodes_table.insert( 0x50, new opcode("BIT 2, B", 2, 8, &cpu::bit_2_b));          /* 0xCB50 - BIT 2, B */
-    extended_opcodes_table.insert( 0x51, new opcode("BIT 2, C", 2, 8, &cpu::bit_2_c));          /* 0xCB51 - BIT 2, C */
-    extended_opcodes_table.insert( 0x52, new opcode("BIT 2, D", 2, 8, &cpu::bit_2_d));          /* 0xCB52 - BIT 2, D */
-    extended_opcodes_table.insert( 0x53, new opcode("BIT 2, E", 2, 8, &cpu::bit_2_e));          /* 0xCB53 - BIT 2, E */
-    extended_opcodes_table.insert( 0x54, new opcode("BIT 2, H", 2, 8, &cpu::bit_2_h));          /* 0xCB54 - BIT 2, H */
-    extended_opcodes_table.insert( 0x55, new opcode("BIT 2, L", 2, 8, &cpu::bit_2_l));          /* 0xCB55 - BIT 2, L */
-    extended_opcodes_table.insert( 0x56, new opcode("BIT 2, (HL)", 2, 16, &cpu::bit_2_hl));     /* 0xCB56 - BIT 2, (HL) */
-    extended_opcodes_table.insert( 0x57, new opcode("BIT 2, A", 2, 8, &cpu::bit_2_a));          /* 0xCB57 - BIT 2, A */
-    extended_opcodes_table.insert( 0x58, new opcode("BIT 3, B", 2, 8, &cpu::bit_3_b));          /* 0xCB58 - BIT 3, B */
-    extended_opcodes_table.insert( 0x59, new opcode("BIT 3, C", 2, 8, &cpu::bit_3_c));          /* 0xCB59 - BIT 3, C */
-    extended_opcodes_table.insert( 0x5A, new opcode("BIT 3, D", 2, 8, &cpu::bit_3_d));          /* 0xCB5A - BIT 3, D */
-    extended_opcodes_table.insert( 0x5B, new opcode("BIT 3, E", 2, 8, &cpu::bit_3_e));          /* 0xCB5B - BIT 3, E */
-    extended_opcodes_table.insert( 0x5C, new opcode("BIT 3, H", 2, 8, &cpu::bit_3_h));          /* 0xCB5C - BIT 3, H */
-    extended_opcodes_table.insert( 0x5D, new opcode("BIT 3, L", 2, 8, &cpu::bit_3_l));          /* 0xCB5D - BIT 3, L */
-    extended_opcodes_table.insert( 0x5E, new opcode("BIT 3, (HL)", 2, 16, &cpu::bit_3_hl));     /* 0xCB5E - BIT 3, (HL) */
-    extended_opcodes_table.insert( 0x5F, new opcode("BIT 3, A", 2, 8, &cpu::bit_3_a));          /* 0xCB5F - BIT 3, A */
-
-    extended_opcodes_table.insert( 0x60, new opcode("BIT 4, B", 2, 8, &cpu::bit_4_b));          /* 0xCB60 - BIT 4, B */
-    extended_opcodes_table.insert( 0x61, new opcode("BIT 4, C", 2, 8, &cpu::bit_4_c));          /* 0xCB61 - BIT 4, C */
-    extended_opcodes_table.insert( 0x62, new opcode("BIT 4, D", 2, 8, &cpu::bit_4_d));          /* 0xCB62 - BIT 4, D */
-    extended_opcodes_table.insert( 0x63, new opcode("BIT 4, E", 2, 8, &cpu::bit_4_e));          /* 0xCB63 - BIT 4, E */
-    extended_opcodes_table.insert( 0x64, new opcode("BIT 4, H", 2, 8, &cpu::bit_4_h));          /* 0xCB64 - BIT 4, H */
-    extended_opcodes_table.insert( 0x65, new opcode("BIT 4, L", 2, 8, &cpu::bit_4_l));          /* 0xCB65 - BIT 4, L */
-    extended_opcodes_table.insert( 0x66, new opcode("BIT 4, (HL)", 2, 16, &cpu::bit_4_hl));     /* 0xCB66 - BIT 4, (HL) */
-    extended_opcodes_table.insert( 0x67, new opcode("BIT 4, A", 2, 8, &cpu::bit_4_a));          /* 0xCB67 - BIT 4, A */
-    extended_opcodes_table.insert( 0x68, new opcode("BIT 5, B", 2, 8, &cpu::bit_5_b));          /* 0xCB68 - BIT 5, B */
-    extended_opcodes_table.insert( 0x69, new opcode("BIT 5, C", 2, 8, &cpu::bit_5_c));          /* 0xCB69 - BIT 5, C */
-    extended_opcodes_table.insert( 0x6A, new opcode("BIT 5, D", 2, 8, &cpu::bit_5_d));          /* 0xCB6A - BIT 5, D */
-    extended_opcodes_table.insert( 0x6B, new opcode("BIT 5, E", 2, 8, &cpu::bit_5_e));          /* 0xCB6B - BIT 5, E */
-    extended_opcodes_table.insert( 0x6C, new opcode("BIT 5, H", 2, 8, &cpu::bit_5_h));          /* 0xCB6C - BIT 5, H */
-    extended_opcodes_table.insert( 0x6D, new opcode("BIT 5, L", 2, 8, &cpu::bit_5_l));          /* 0xCB6D - BIT 5, L */
-    extended_opcodes_table.insert( 0x6E, new opcode("BIT 5, (HL)", 2, 16, &cpu::bit_5_hl));     /* 0xCB6E - BIT 5, (HL) */
-    extended_opcodes_table.insert( 0x6F, new opcode("BIT 5, A", 2, 8, &cpu::bit_5_a));          /* 0xCB6F - BIT 5, A */
-
-    extended_opcodes_table.insert( 0x70, new opcode("BIT 6, B", 2, 8, &cpu::bit_6_b));          /* 0xCB70 - BIT 6, B */
-    extended_opcodes_table.insert( 0x71, new opcode("BIT 6, C", 2, 8, &cpu::bit_6_c));          /* 0xCB71 - BIT 6, C */
-    extended_opcodes_table.insert( 0x72, new opcode("BIT 6, D", 2, 8, &cpu::bit_6_d));          /* 0xCB72 - BIT 6, D */
-    extended_opcodes_table.insert( 0x73, new opcode("BIT 6, E", 2, 8, &cpu::bit_6_e));          /* 0xCB73 - BIT 6, E */
-    extended_opcodes_table.insert( 0x74, new opcode("BIT 6, H", 2, 8, &cpu::bit_6_h));          /* 0xCB74 - BIT 6, H */
-    extended_opcodes_table.insert( 0x75, new opcode("BIT 6, L", 2, 8, &cpu::bit_6_l));          /* 0xCB75 - BIT 6, L */
-    extended_opcodes_table.insert( 0x76, new opcode("BIT 6, (HL)", 2, 16, &cpu::bit_6_hl));     /* 0xCB76 - BIT 6, (HL) */
-    extended_opcodes_table.insert( 0x77, new opcode("BIT 6, A", 2, 8, &cpu::bit_6_a));          /* 0xCB77 - BIT 6, A */
-    extended_opcodes_table.insert( 0x78, new opcode("BIT 7, B", 2, 8, &cpu::bit_7_b));          /* 0xCB78 - BIT 7, B */
-    extended_opcodes_table.insert( 0x79, new opcode("BIT 7, C", 2, 8, &cpu::bit_7_c));          /* 0xCB79 - BIT 7, C */
-    extended_opcodes_table.insert( 0x7A, new opcode("BIT 7, D", 2, 8, &cpu::bit_7_d));          /* 0xCB7A - BIT 7, D */
-    extended_opcodes_table.insert( 0x7B, new opcode("BIT 7, E", 2, 8, &cpu::bit_7_e));          /* 0xCB7B - BIT 7, E */
-    extended_opcodes_table.insert( 0x7C, new opcode("BIT 7, H", 2, 8, &cpu::bit_7_h));          /* 0xCB7C - BIT 7, H */
-    extended_opcodes_table.insert( 0x7D, new opcode("BIT 7, L", 2, 8, &cpu::bit_7_l));          /* 0xCB7D - BIT 7, L */
-    extended_opcodes_table.insert( 0x7E, new opcode("BIT 7, (HL)", 2, 16, &cpu::bit_7_hl));     /* 0xCB7E - BIT 7, (HL) */
-    extended_opcodes_table.insert( 0x7F, new opcode("BIT 7, A", 2, 8, &cpu::bit_7_a));          /* 0xCB7F - BIT 7, A */
-
-    extended_opcodes_table.insert( 0x80, new opcode("RES 0, B", 2, 8, &cpu::res_0_b));          /* 0xCB80 - RES 0, B */
-    extended_opcodes_table.insert( 0x81, new opcode("RES 0, C", 2, 8, &cpu::res_0_c));          /* 0xCB81 - RES 0, C */
-    extended_opcodes_table.insert( 0x82, new opcode("RES 0, D", 2, 8, &cpu::res_0_d));          /* 0xCB82 - RES 0, D */
-    extended_opcodes_table.insert( 0x83, new opcode("RES 0, E", 2, 8, &cpu::res_0_e));          /* 0xCB83 - RES 0, E */
-    extended_opcodes_table.insert( 0x84, new opcode("RES 0, H", 2, 8, &cpu::res_0_h));          /* 0xCB84 - RES 0, H */
-    extended_opcodes_table.insert( 0x85, new opcode("RES 0, L", 2, 8, &cpu::res_0_l));          /* 0xCB85 - RES 0, L */
-    extended_opcodes_table.insert( 0x86, new opcode("RES 0, (HL)", 2, 16, &cpu::res_0_hl));     /* 0xCB86 - RES 0, (HL) */
-    extended_opcodes_table.insert( 0x87, new opcode("RES 0, A", 2, 8, &cpu::res_0_a));          /* 0xCB87 - RES 0, A */
-    extended_opcodes_table.insert( 0x88, new opcode("RES 1, B", 2, 8, &cpu::res_1_b));          /* 0xCB88 - RES 1, B */
-    extended_opcodes_table.insert( 0x89, new opcode("RES 1, C", 2, 8, &cpu::res_1_c));          /* 0xCB89 - RES 1, C */
-    extended_opcodes_table.insert( 0x8A, new opcode("RES 1, D", 2, 8, &cpu::res_1_d));          /* 0xCB8A - RES 1, D */
-    extended_opcodes_table.insert( 0x8B, new opcode("RES 1, E", 2, 8, &cpu::res_1_e));          /* 0xCB8B - RES 1, E */
-    extended_opcodes_table.insert( 0x8C, new opcode("RES 1, H", 2, 8, &cpu::res_1_h));          /* 0xCB8C - RES 1, H */
-    extended_opcodes_table.insert( 0x8D, new opcode("RES 1, L", 2, 8, &cpu::res_1_l));          /* 0xCB8D - RES 1, L */
-    extended_opcodes_table.insert( 0x8E, new opcode("RES 1, (HL)", 2, 16, &cpu::res_1_hl));     /* 0xCB8E - RES 1, (HL) */
-    extended_opcodes_table.insert( 0x8F, new opcode("RES 1, A", 2, 8, &cpu::res_1_a));          /* 0xCB8F - RES 1, A */
-}
-
-cpu::~cpu()
-{
-    //delete opcodes
-    QMap<quint8, opcode*>::iterator it;
-    for(it = opcodes_table.begin() ; it != opcodes_table.end() ; ++it)
+/* Clock the cpu by one cycle. The opcode is executed as a whole on its first cycle,
+ * the following calls only wait for its cycles to elapse.
+ *
+ * Returns false if the cpu is stopped.
+ */
+bool cpu::interpret_opcode()
+{
+    if(cycles_counter > 0)
     {
-        if(it.value()) delete it.value();
+        cycles_counter--;
+        return true;
     }
 
-    for(it = extended_opcodes_table.begin() ; it != extended_opcodes_table.end() ; ++it)
+    quint8 cycles = step_instruction();
+
+    if(!cycles) return false;
+
+    cycles_counter = cycles - 1;
+
+    return true;
+}
+
+/* Execute one whole opcode.
+ *
+ * Returns the number of cycles it took, or 0 if the cpu is stopped.
+ */
+quint8 cpu::step_instruction()
+{
+    if(HALT)
     {
-        if(it.value()) delete it.value();
+        if(!interrupt_pending()) return 4;
+
+        HALT = false;
     }
+
+    if(STOP) return 0;
+
+    last_opcode_not_executed = false;
+
+    current_opcode = &opcodes_table[fetch(PC)];
+    fetch_operand();
+
+    (this->*(current_opcode->exec))();
+
+    PC += current_opcode->length;
+
+    return last_opcode_not_executed ? current_opcode->not_exec_cycles : current_opcode->cycles;
 }
 
-bool cpu::interpret_opcode()
+/* Execute whole opcodes until at least the given number of cycles has elapsed.
+ *
+ * Returns the number of cycles actually elapsed, which can be a few more than asked
+ * since the last opcode is never split, or less if the cpu stopped.
+ */
+quint32 cpu::run_for(quint32 cycles)
 {
-    if(HALT) return true;
+    quint32 elapsed = 0;
+
+    loop_state loop;
+    save_loop_state(&loop, elapsed);
 
-    if(current_opcode != NULL)
+    quint16 last_pc = PC;
+    quint32 last_elapsed = 0;
+
+    while(elapsed < cycles)
     {
-        if(!last_opcode_not_executed)
+        //oam dma : the cpu is left to wait in hram as programs do, only the transfer time is accounted
+        //vram dma : the hblank dma blocks due, and the cycles the copies stalled the cpu
+        if(memory.dma_active())
+            elapsed += memory.elapse_dma(elapsed - last_elapsed);
+
+        last_elapsed = elapsed;
+
+        if(HALT)
+        {
+            elapsed += halted_cycles(cycles - elapsed);
+
+            if(HALT) continue;
+        }
+
+        //PC went back a few bytes : maybe the head of a loop
+        if((quint16)(last_pc - PC) < POLLING_LOOP_MAX_SIZE)
+            elapsed += skip_polling_loop(&loop, elapsed, cycles);
+
+        last_pc = PC;
+
+#ifdef GB_THREADED_CORE
+        if(!HALT && !STOP && !memory.dma_active())
+        {
+            elapsed += run_threaded(cycles - elapsed);
+            continue;
+        }
+#elif defined(GB_BLOCK_CACHE)
+        if(!HALT && !STOP)
         {
-            if(cycles_counter < current_opcode->cycles)
+            quint32 block_cycles = run_block(cycles - elapsed);
+
+            if(block_cycles)
             {
-                cycles_counter++;
-                return true;
+                elapsed += block_cycles;
+                continue;
             }
         }
-        else
+#elif defined(GB_JIT)
+        //blocks end on every opcode after which an interrupt can be taken
+        if(!HALT && !STOP)
         {
-            if(cycles_counter < current_opcode->not_exec_cycles)
+            quint32 block_cycles = _JIT->run(this, cycles - elapsed);
+
+            if(block_cycles)
             {
-                cycles_counter++;
-                return true;
+                elapsed += block_cycles;
+                continue;
             }
         }
-    }
-
-    if(STOP) return false;
-
-    last_opcode_not_executed = false;
-
-    quint8 opcode_id = _MMU->rb(PC);
-    const opcode* op = opcodes_table.value(opcode_id);
+#endif
 
-    memcpy(current_opcode, op, sizeof(opcode));
+        quint8 step = step_instruction();
 
-    (this->*(current_opcode->exec))();
+        if(!step) break;
 
-    cycles_counter = 1;
+        elapsed += step;
+    }
 
-    PC += current_opcode->length;
+    if(memory.dma_active())
+        elapsed += memory.elapse_dma(elapsed - last_elapsed);
 
-    return true;
+    return elapsed;
 }
 
 quint16 cpu::get_pc()
@@ -544,38 +866,203 @@ quint16 cpu::get_pc()
     return PC;
 }
 
+quint8 cpu::get_f()
+{
+    sync_flags();
+    return _F;
+}
 
+/* Mnemonic of the opcode at the given address, for the debugger and the tracer */
+const char* cpu::get_mnemonic(quint16 address)
+{
+    quint8 code = memory.rb(address);
 
+    if(code == 0xCB) return extended_opcodes_mnemonics[memory.rb(address + 1)];
 
+    return opcodes_mnemonics[code];
+}
 
 void cpu::write_on_register(DOUBLE_REGISTERS reg, quint16 word)
 {
     switch(reg)
     {
     case REGISTER_BC:
-        _B = ((word & 0xFF00) >> 8);
-        _C = word & 0xFF;
+        _BC = word;
         break;
 
     case REGISTER_DE:
-        _D = ((word & 0xFF00) >> 8);
-        _E = word & 0xFF;
+        _DE = word;
         break;
 
     case REGISTER_HL:
-        _H = ((word & 0xFF00) >> 8);
-        _L = word & 0xFF;
+        _HL = word;
         break;
     }
 }
 
+/* Start as if the bios of the given model just ran, without running it : registers and io
+ * registers get the values it leaves (Pan Docs, power up sequence), and the cartridge starts at 0x0100.
+ * The CGB values are the ones of a CGB cartridge.
+ */
+void cpu::fast_boot(mmu::MODEL model)
+{
+    Q_ASSERT(model < mmu::MODEL_COUNT);
+
+    static const quint16 post_boot_registers[mmu::MODEL_COUNT][4] =
+    {
+        // AF      BC      DE      HL
+        {0x01B0, 0x0013, 0x00D8, 0x014D},   // DMG
+        {0xFFB0, 0x0013, 0x00D8, 0x014D},   // MGB
+        {0x1180, 0x0000, 0xFF56, 0x000D}    // CGB
+    };
+
+    memory.fast_boot(model);
+
+    _AF = post_boot_registers[model][0];
+    _BC = post_boot_registers[model][1];
+    _DE = post_boot_registers[model][2];
+    _HL = post_boot_registers[model][3];
+
+    flags_op = FLAGS_NONE;
+    SP = 0xFFFE;
+    PC = 0x0100;
+
+    cycles_counter = 0;
+
+    STOP = false;
+    HALT = false;
+    IME = false;
+    last_opcode_not_executed = false;
+}
+
+
+/////////////////////////////////////
+// FETCH FUNCTIONS
+/////////////////////////////////////
+
+/* Read a byte of the instruction stream (opcode or immediate operand).
+ * The mmu keeps the page opcodes are fetched from (see mmu::fetch()), and forgets it whenever
+ * the memory map changes (bios switched off, bank switching).
+ */
+inline quint8 cpu::fetch(quint16 address)
+{
+    return memory.fetch(address);
+}
+
+/* Read the immediate value of the current opcode, which the handlers get through _d8, _d16,
+ * _a8, _a16 and _r8 (for 0xCB, the byte selecting the extended opcode).
+ */
+inline void cpu::fetch_operand()
+{
+    switch(current_opcode->length)
+    {
+    case 3:
+        operand = fetch(PC+1) + (fetch(PC+2) << 8);
+        break;
+
+    case 2:
+        operand = fetch(PC+1);
+        break;
+    }
+}
+
+
+/////////////////////////////////////
+// INTERRUPT FUNCTIONS
+/////////////////////////////////////
+
+/* True if an interrupt is both requested and enabled, which ends HALT whatever IME is */
+bool cpu::interrupt_pending()
+{
+    return (memory.rb(INTERRUPT_FLAG) & memory.rb(INTERRUPT_ENABLE) & INTERRUPT_MASK) != 0;
+}
+
+/* Skip the clock of a halted cpu forward to the next event which can end HALT, instead of
+ * stepping 4 cycles at a time. Nothing (timer, lcd...) raises interrupts while the cpu runs yet,
+ * so the only events are an interrupt already pending, the end of the given cycles and the next
+ * step of a running dma (oam dma landing, hblank dma block), which run_for() must see at the right
+ * time.
+ *
+ * Returns the number of cycles skipped, a multiple of 4 as if HALT had been stepped. HALT is
+ * reset if an interrupt is pending.
+ */
+quint32 cpu::halted_cycles(quint32 cycles)
+{
+    if(interrupt_pending())
+    {
+        HALT = false;
+        return 0;
+    }
+
+    if(memory.dma_cycles_left())
+        cycles = qMin<quint32>(cycles, memory.dma_cycles_left());
+
+    return (cycles + 3) & ~3;
+}
+
+/////////////////////////////////////
+// POLLING LOOP FUNCTIONS
+/////////////////////////////////////
+
+void cpu::save_loop_state(loop_state* loop, quint32 elapsed)
+{
+    loop->address = PC;
+    loop->af = (_A << 8) | get_f();
+    loop->bc = _BC;
+    loop->de = _DE;
+    loop->hl = _HL;
+    loop->sp = SP;
+    loop->ime = IME;
+    loop->writes = memory.writes_count();
+    loop->handler_reads = memory.handler_reads_count();
+    loop->elapsed = elapsed;
+}
+
+/* Called by run_for() when PC went back to what may be the head of a loop.
+ *
+ * If the cpu is back at the same address in the same state as the last time, without any write
+ * to memory in between, the loop only waits for something else to change memory (a flag set by
+ * an interrupt, the end of a dma...) : every following turn will be the same. A loop reading an
+ * io register with a peripheral handler (LY, DIV, STAT...) is never skipped, as what it reads may
+ * change with time alone.
+ * Nothing else runs while the cpu does yet, so the turns are skipped up to the end of the cycles,
+ * or up to the next step of a running dma (oam dma landing, hblank dma block), since the loop may
+ * poll what it changes. The last (maybe partial) turn is still executed, so that the cpu ends in
+ * the very state it would have had running the loop.
+ *
+ * Returns the number of cycles skipped.
+ */
+quint32 cpu::skip_polling_loop(loop_state* loop, quint32 elapsed, quint32 cycles)
+{
+    loop_state previous = *loop;
+
+    save_loop_state(loop, elapsed);
+
+    if(previous.address != loop->address
+            || previous.af != loop->af || previous.bc != loop->bc || previous.de != loop->de
+            || previous.hl != loop->hl || previous.sp != loop->sp || previous.ime != loop->ime
+            || previous.writes != loop->writes || previous.handler_reads != loop->handler_reads
+            || previous.elapsed == elapsed)
+        return 0;
+
+    if(memory.dma_cycles_left())
+        cycles = qMin<quint32>(cycles, elapsed + memory.dma_cycles_left());
+
+    quint32 turn = elapsed - previous.elapsed;
+    quint32 skipped = (cycles - elapsed - 1) / turn * turn;
+
+    loop->elapsed += skipped;
+
+    return skipped;
+}
 
 /////////////////////////////////////
 // FLAG FUNCTIONS
 /////////////////////////////////////
 bool cpu::z_flag()
 {
-    return F & FLAG_Z;
+    sync_flags();
+    return _F & FLAG_Z;
 }
 
 void cpu::check_z(quint16 val)
@@ -586,35 +1073,41 @@ void cpu::check_z(quint16 val)
 
 void cpu::set_z()
 {
-    F |= FLAG_Z;
+    sync_flags();
+    _F |= FLAG_Z;
 }
 
 void cpu::reset_z()
 {
-    F &= ~FLAG_Z;
+    sync_flags();
+    _F &= ~FLAG_Z;
 }
 
 
 bool cpu::n_flag()
 {
-    return F & FLAG_N;
+    sync_flags();
+    return _F & FLAG_N;
 }
 
 void cpu::set_n()
 {
-    F |= FLAG_N;
+    sync_flags();
+    _F |= FLAG_N;
 }
 
 void cpu::reset_n()
 {
-    F &= ~FLAG_N;
+    sync_flags();
+    _F &= ~FLAG_N;
 }
 
 
 
 bool cpu::h_flag()
 {
-    return F & FLAG_H;
+    sync_flags();
+    return _F & FLAG_H;
 }
 
 void cpu::check_h_add8(quint8 val1, quint8 val2)
@@ -637,18 +1130,24 @@ void cpu::check_h_sub8(quint8 val1, quint8 val2)
 
 void cpu::set_h()
 {
-    F |= FLAG_H;
+    sync_flags();
+    _F |= FLAG_H;
 }
 
 void cpu::reset_h()
 {
-    F &= ~FLAG_H;
+    sync_flags();
+    _F &= ~FLAG_H;
 }
 
 
 bool cpu::c_flag()
 {
-    return F & FLAG_C;
+#ifdef GB_LAZY_FLAGS
+    // carry is recorded along with the operation, so ADC, SBC, INC and DEC do not materialize F
+    if(flags_op != FLAGS_NONE) return flags_carry;
+#endif
+    return _F & FLAG_C;
 }
 
 void cpu::check_c_rl(quint8 reg)
@@ -683,140 +1182,898 @@ void cpu::check_c_sub8(quint8 val1, quint8 val2)
 
 void cpu::set_c()
 {
-    F |= FLAG_C;
+    sync_flags();
+    _F |= FLAG_C;
 }
 
 void cpu::reset_c()
 {
-    F &= ~FLAG_C;
+    sync_flags();
+    _F &= ~FLAG_C;
 }
 
 /////////////////////////////////////
-// OPCODE FUNCTIONS
+// ALU FUNCTIONS
 /////////////////////////////////////
 
-void cpu::not_impl()
+/* The 8-bit arithmetic opcodes go through these functions.
+ *
+ * When built with GB_LAZY_FLAGS, they do not touch F: they only record the kind of
+ * the operation and its operands, and sync_flags() computes Z, N, H and C from that
+ * record the first time F is actually read (flag test, PUSH AF, get_f()...).
+ * Otherwise flags are updated right away.
+ */
+
+void cpu::sync_flags()
 {
-    std::cerr << "Opcode not implemented" << std::endl;
-    exit(EXIT_FAILURE);
+#ifdef GB_LAZY_FLAGS
+    if(flags_op != FLAGS_NONE) materialize_flags();
+#endif
 }
 
-/* 0x00 NOP : No Operation
- *
- * Flags affected:
- * None
- */
-void cpu::nop()
+void cpu::materialize_flags()
 {
+    quint8 a = flags_val1;
+    quint8 b = flags_val2;
+    bool z = false, n = false, h = false, c = flags_carry;
+
+    switch(flags_op)
+    {
+    case FLAGS_ADD:
+        z = !(quint8)(a + b);
+        h = ((a & 0xF) + (b & 0xF)) & 0x10;
+        break;
+
+    case FLAGS_SUB:
+        z = (a == b);
+        n = true;
+        h = (a & 0xF) < (b & 0xF);
+        break;
+
+    case FLAGS_AND:
+        z = !a;
+        h = true;
+        break;
+
+    case FLAGS_LOGIC:
+        z = !a;
+        break;
 
+    case FLAGS_INC:
+        z = !(quint8)(a + 1);
+        h = ((a & 0xF) + 1) & 0x10;
+        break;
+
+    case FLAGS_DEC:
+        z = !(quint8)(a - 1);
+        n = true;
+        h = (a & 0xF) < 1;
+        break;
+
+    default:
+        return;
+    }
+
+    flags_op = FLAGS_NONE;
+
+    _F = (_F & 0x0F) | (z ? FLAG_Z : 0) | (n ? FLAG_N : 0) | (h ? FLAG_H : 0) | (c ? FLAG_C : 0);
 }
 
-/* 0x01 LD BC, d16 : Load 16-bit immediate into BC
- *
- * Flags affected:
- * None
- */
-void cpu::ld_bc_d16()
+void cpu::alu_add(quint8 val)
 {
-    write_on_register(REGISTER_BC, _d16);
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_ADD;
+    flags_val1 = _A;
+    flags_val2 = val;
+    flags_carry = (_A + val) > 0xFF;
+#else
+    reset_n();
+    check_h_add8(_A, val);
+    check_c_add8(_A, val);
+#endif
+
+    _A += val;
+
+#ifndef GB_LAZY_FLAGS
+    check_z(_A);
+#endif
 }
 
-/* 0x02 LD (BC), A : Save A to address pointed by BC
- *
- * Flags affected:
- * None
- */
-void cpu::ld_bc_a()
+void cpu::alu_adc(quint8 val)
 {
-    _MMU->wb(_BC, _A);
+    alu_add(val + (c_flag() ? 1 : 0));
 }
 
-/* 0x03 INC BC : Increment 16-bit BC
- *
- * Flags affected:
- * None
- */
-void cpu::inc_bc()
+void cpu::alu_sub(quint8 val)
 {
-    _C++;
-    if(!_C) _B++;
+    alu_cp(val);
+
+    _A -= val;
 }
 
-/* 0x04 INC B : Increment B
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Set if carry from bit 3.
- * C - Not affected.
- */
-void cpu::inc_b()
+void cpu::alu_sbc(quint8 val)
 {
-    check_h_add8(_B, 1);
+    alu_sub(val + (c_flag() ? 1 : 0));
+}
 
-    _B++;
+void cpu::alu_and(quint8 val)
+{
+    _A &= val;
 
-    check_z(_B);
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_AND;
+    flags_val1 = _A;
+    flags_carry = false;
+#else
     reset_n();
+    set_h();
+    reset_c();
+    check_z(_A);
+#endif
 }
 
-/* 0x05 DEC B : Decrement B
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Set.
- * H - Set if no borrow from bit 4.
- * C - Not affected.
- */
-void cpu::dec_b()
+void cpu::alu_xor(quint8 val)
 {
-    check_h_sub8(_B, 1);
-
-    _B--;
+    _A ^= val;
 
-    check_z(_B);
-    set_n();
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_LOGIC;
+    flags_val1 = _A;
+    flags_carry = false;
+#else
+    reset_n();
+    reset_h();
+    reset_c();
+    check_z(_A);
+#endif
 }
 
-/* 0x06 LD B, d8 : Load 8-bit immediate into B
- *
- * Flags affected:
- * None
- */
-void cpu::ld_b_d8()
+void cpu::alu_or(quint8 val)
 {
-    _B = _d8;
-}
+    _A |= val;
 
-/* 0x07 RLCA : Rotate A left. Old bit 7 to Carry flag.
- *
- * Flags affected:
- * Z - Reset.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rlca()
-{
-    reset_z();
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_LOGIC;
+    flags_val1 = _A;
+    flags_carry = false;
+#else
     reset_n();
     reset_h();
+    reset_c();
+    check_z(_A);
+#endif
+}
 
-    check_c_rl(_A);
-
-    _A = ( (_A & 0x80) ? (_A << 1) + 1 : (_A << 1) );
+void cpu::alu_cp(quint8 val)
+{
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_SUB;
+    flags_val1 = _A;
+    flags_val2 = val;
+    flags_carry = _A < val;
+#else
+    set_n();
+    check_h_sub8(_A, val);
+    check_c_sub8(_A, val);
+    check_z(_A - val);
+#endif
+}
 
+void cpu::alu_inc(quint8& reg)
+{
+#ifdef GB_LAZY_FLAGS
+    flags_carry = c_flag();
+    flags_op = FLAGS_INC;
+    flags_val1 = reg;
+#else
+    check_h_add8(reg, 1);
+    check_z((quint8)(reg + 1));
+    reset_n();
+#endif
 
+    reg++;
 }
 
-/* 0x08 LD (a16), SP : Save SP to given address
- *
- * Flags affected:
- * None
- */
-void cpu::ld_a16_sp()
+void cpu::alu_dec(quint8& reg)
 {
-    _MMU->ww(_a16, SP);
+#ifdef GB_LAZY_FLAGS
+    flags_carry = c_flag();
+    flags_op = FLAGS_DEC;
+    flags_val1 = reg;
+#else
+    check_h_sub8(reg, 1);
+    check_z((quint8)(reg - 1));
+    set_n();
+#endif
+
+    reg--;
+}
+
+/////////////////////////////////////
+// THREADED CORE
+/////////////////////////////////////
+
+/* Alternative interpreter core used by run_for() when built with GB_THREADED_CORE.
+ *
+ * The registers are copied into locals so the compiler can keep them in host registers,
+ * and the common opcodes are expanded inline in this single function. With GCC or Clang,
+ * dispatch is threaded through a table of label addresses (computed goto), otherwise it
+ * falls back to a switch. Define GB_NO_COMPUTED_GOTO to force the switch.
+ *
+ * Every inlined opcode has the same semantics as its handler. Opcodes which are not
+ * inlined (jumps, calls, stack, interrupts, CB prefix...) go through the handlers table,
+ * with the registers written back before and reloaded after.
+ *
+ * Returns the number of cycles elapsed. Returns early if the cpu halted or stopped, or once a dma
+ * is running, which run_for() steps through opcode by opcode.
+ */
+quint32 cpu::run_threaded(quint32 cycles)
+{
+#if defined(__GNUC__) && !defined(GB_NO_COMPUTED_GOTO)
+#define GB_COMPUTED_GOTO
+#endif
+
+#define LOAD_REGISTERS()    sync_flags(); af = AF; bc = BC; de = DE; hl = HL; sp = SP; pc = PC
+#define STORE_REGISTERS()   AF = af; BC = bc; DE = de; HL = hl; SP = sp; PC = pc
+
+#define a                   (af.bytes.high)
+#define f                   (af.bytes.low)
+#define b                   (bc.bytes.high)
+#define c                   (bc.bytes.low)
+#define d                   (de.bytes.high)
+#define e                   (de.bytes.low)
+#define h                   (hl.bytes.high)
+#define l                   (hl.bytes.low)
+#define D8                  ( fetch(pc + 1) )
+#define D16                 ( (quint16)(fetch(pc + 1) + (fetch(pc + 2) << 8)) )
+
+#define SET_FLAGS(z, n, hc, cy) f = (quint8)( (f & 0x0F) | ((z) ? FLAG_Z : 0) | ((n) ? FLAG_N : 0) | ((hc) ? FLAG_H : 0) | ((cy) ? FLAG_C : 0) )
+
+// like the handlers, INC (HL) and DEC (HL) take Z from the value read back after the write
+#define CHECK_Z(v)          f = (quint8)( (v) ? (f & ~FLAG_Z) : (f | FLAG_Z) )
+
+#define ALU_ADD(v)          { quint8 val = (v); SET_FLAGS( !(quint8)(a + val), 0, ((a & 0xF) + (val & 0xF)) & 0x10, (a + val) > 0xFF ); a += val; }
+#define ALU_ADC(v)          ALU_ADD( (quint8)((v) + ((f & FLAG_C) ? 1 : 0)) )
+#define ALU_SUB(v)          { quint8 val = (v); SET_FLAGS( a == val, 1, (a & 0xF) < (val & 0xF), a < val ); a -= val; }
+#define ALU_SBC(v)          ALU_SUB( (quint8)((v) + ((f & FLAG_C) ? 1 : 0)) )
+#define ALU_AND(v)          { a &= (v); SET_FLAGS( !a, 0, 1, 0 ); }
+#define ALU_XOR(v)          { a ^= (v); SET_FLAGS( !a, 0, 0, 0 ); }
+#define ALU_OR(v)           { a |= (v); SET_FLAGS( !a, 0, 0, 0 ); }
+#define ALU_CP(v)           { quint8 val = (v); SET_FLAGS( a == val, 1, (a & 0xF) < (val & 0xF), a < val ); }
+#define ALU_INC(r)          { SET_FLAGS( !(quint8)(r + 1), 0, ((r & 0xF) + 1) & 0x10, f & FLAG_C ); r++; }
+#define ALU_DEC(r)          { SET_FLAGS( !(quint8)(r - 1), 1, (r & 0xF) < 1, f & FLAG_C ); r--; }
+
+// lengths and cycles are read from the constexpr opcodes table, so they fold into constants
+#define NEXT(id)            pc += opcodes_table[id].length; elapsed += opcodes_table[id].cycles; DISPATCH()
+// only a write can start a dma, which sends back to run_for()
+#define NEXT_WRITE(id)      pc += opcodes_table[id].length; elapsed += opcodes_table[id].cycles; if(m->dma_active()) goto done; DISPATCH()
+
+#ifdef GB_COMPUTED_GOTO
+#define OPCODE(id)          op_##id:
+#define DISPATCH()          if(elapsed >= cycles) goto done; op = fetch(pc); goto *dispatch_table[op]
+#else
+#define OPCODE(id)          case id:
+#define DISPATCH()          goto dispatch
+#endif
+
+    register_pair af, bc, de, hl;
+    quint16 sp, pc;
+    quint8 op, tmp;
+
+    quint32 elapsed = 0;
+    mmu* m = &memory;
+
+    LOAD_REGISTERS();
+
+#ifdef GB_COMPUTED_GOTO
+    static const void* const dispatch_table[256] =
+    {
+        &&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07,
+        &&fallback, &&fallback, &&op_0x0A, &&op_0x0B, &&op_0x0C, &&op_0x0D, &&op_0x0E, &&op_0x0F,
+        &&fallback, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17,
+        &&fallback, &&fallback, &&op_0x1A, &&op_0x1B, &&op_0x1C, &&op_0x1D, &&op_0x1E, &&op_0x1F,
+        &&fallback, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&fallback,
+        &&fallback, &&fallback, &&op_0x2A, &&op_0x2B, &&op_0x2C, &&op_0x2D, &&op_0x2E, &&op_0x2F,
+        &&fallback, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37,
+        &&fallback, &&fallback, &&op_0x3A, &&op_0x3B, &&op_0x3C, &&op_0x3D, &&op_0x3E, &&op_0x3F,
+        &&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47,
+        &&op_0x48, &&op_0x49, &&op_0x4A, &&op_0x4B, &&op_0x4C, &&op_0x4D, &&op_0x4E, &&op_0x4F,
+        &&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57,
+        &&op_0x58, &&op_0x59, &&op_0x5A, &&op_0x5B, &&op_0x5C, &&op_0x5D, &&op_0x5E, &&op_0x5F,
+        &&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67,
+        &&op_0x68, &&op_0x69, &&op_0x6A, &&op_0x6B, &&op_0x6C, &&op_0x6D, &&op_0x6E, &&op_0x6F,
+        &&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&fallback, &&op_0x77,
+        &&op_0x78, &&op_0x79, &&op_0x7A, &&op_0x7B, &&op_0x7C, &&op_0x7D, &&op_0x7E, &&op_0x7F,
+        &&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87,
+        &&op_0x88, &&op_0x89, &&op_0x8A, &&op_0x8B, &&op_0x8C, &&op_0x8D, &&op_0x8E, &&op_0x8F,
+        &&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97,
+        &&op_0x98, &&op_0x99, &&op_0x9A, &&op_0x9B, &&op_0x9C, &&op_0x9D, &&op_0x9E, &&op_0x9F,
+        &&op_0xA0, &&op_0xA1, &&op_0xA2, &&op_0xA3, &&op_0xA4, &&op_0xA5, &&op_0xA6, &&op_0xA7,
+        &&op_0xA8, &&op_0xA9, &&op_0xAA, &&op_0xAB, &&op_0xAC, &&op_0xAD, &&op_0xAE, &&op_0xAF,
+        &&op_0xB0, &&op_0xB1, &&op_0xB2, &&op_0xB3, &&op_0xB4, &&op_0xB5, &&op_0xB6, &&op_0xB7,
+        &&op_0xB8, &&op_0xB9, &&op_0xBA, &&op_0xBB, &&op_0xBC, &&op_0xBD, &&op_0xBE, &&op_0xBF,
+        &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xC6, &&fallback,
+        &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xCE, &&fallback,
+        &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xD6, &&fallback,
+        &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xDE, &&fallback,
+        &&op_0xE0, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xE6, &&fallback,
+        &&fallback, &&fallback, &&op_0xEA, &&fallback, &&fallback, &&fallback, &&op_0xEE, &&fallback,
+        &&op_0xF0, &&fallback, &&fallback, &&fallback, &&fallback, &&fallback, &&op_0xF6, &&fallback,
+        &&fallback, &&op_0xF9, &&op_0xFA, &&fallback, &&fallback, &&fallback, &&op_0xFE, &&fallback
+    };
+
+    DISPATCH();
+#else
+dispatch:
+    if(elapsed >= cycles) goto done;
+    op = fetch(pc);
+
+    switch(op)
+    {
+#endif
+
+    OPCODE(0x00) NEXT(0x00);                                                // NOP
+    OPCODE(0x01) bc.word = D16; NEXT(0x01);                                 // LD BC, d16
+    OPCODE(0x02) m->wb(bc.word, a); NEXT_WRITE(0x02);                       // LD (BC), A
+    OPCODE(0x03) bc.word++; NEXT(0x03);                                     // INC BC
+    OPCODE(0x04) ALU_INC(b); NEXT(0x04);                                    // INC B
+    OPCODE(0x05) ALU_DEC(b); NEXT(0x05);                                    // DEC B
+    OPCODE(0x06) b = D8; NEXT(0x06);                                        // LD B, d8
+    OPCODE(0x07) SET_FLAGS(0, 0, 0, a & 0x80); a = (a << 1) | (a >> 7); NEXT(0x07); // RLCA
+    OPCODE(0x0A) a = m->rb(bc.word); NEXT(0x0A);                            // LD A, (BC)
+    OPCODE(0x0B) bc.word--; NEXT(0x0B);                                     // DEC BC
+    OPCODE(0x0C) ALU_INC(c); NEXT(0x0C);                                    // INC C
+    OPCODE(0x0D) ALU_DEC(c); NEXT(0x0D);                                    // DEC C
+    OPCODE(0x0E) c = D8; NEXT(0x0E);                                        // LD C, d8
+    OPCODE(0x0F) SET_FLAGS(0, 0, 0, a & 0x01); a = (a >> 1) | (a << 7); NEXT(0x0F); // RRCA
+
+    OPCODE(0x11) de.word = D16; NEXT(0x11);                                 // LD DE, d16
+    OPCODE(0x12) m->wb(de.word, a); NEXT_WRITE(0x12);                       // LD (DE), A
+    OPCODE(0x13) de.word++; NEXT(0x13);                                     // INC DE
+    OPCODE(0x14) ALU_INC(d); NEXT(0x14);                                    // INC D
+    OPCODE(0x15) ALU_DEC(d); NEXT(0x15);                                    // DEC D
+    OPCODE(0x16) d = D8; NEXT(0x16);                                        // LD D, d8
+    OPCODE(0x17) tmp = a & 0x80; a = (a << 1) | ((f & FLAG_C) ? 1 : 0); SET_FLAGS(0, 0, 0, tmp); NEXT(0x17); // RLA
+    OPCODE(0x1A) a = m->rb(de.word); NEXT(0x1A);                            // LD A, (DE)
+    OPCODE(0x1B) de.word--; NEXT(0x1B);                                     // DEC DE
+    OPCODE(0x1C) ALU_INC(e); NEXT(0x1C);                                    // INC E
+    OPCODE(0x1D) ALU_DEC(e); NEXT(0x1D);                                    // DEC E
+    OPCODE(0x1E) e = D8; NEXT(0x1E);                                        // LD E, d8
+    OPCODE(0x1F) tmp = a & 0x01; a = (a >> 1) | ((f & FLAG_C) ? 0x80 : 0); SET_FLAGS(0, 0, 0, tmp); NEXT(0x1F); // RRA
+
+    OPCODE(0x21) hl.word = D16; NEXT(0x21);                                 // LD HL, d16
+    OPCODE(0x22) m->wb(hl.word, a); hl.word++; NEXT_WRITE(0x22);            // LDI (HL), A
+    OPCODE(0x23) hl.word++; NEXT(0x23);                                     // INC HL
+    OPCODE(0x24) ALU_INC(h); NEXT(0x24);                                    // INC H
+    OPCODE(0x25) ALU_DEC(h); NEXT(0x25);                                    // DEC H
+    OPCODE(0x26) h = D8; NEXT(0x26);                                        // LD H, d8
+    OPCODE(0x2A) a = m->rb(hl.word); hl.word++; NEXT(0x2A);                 // LDI A, (HL)
+    OPCODE(0x2B) hl.word--; NEXT(0x2B);                                     // DEC HL
+    OPCODE(0x2C) ALU_INC(l); NEXT(0x2C);                                    // INC L
+    OPCODE(0x2D) ALU_DEC(l); NEXT(0x2D);                                    // DEC L
+    OPCODE(0x2E) l = D8; NEXT(0x2E);                                        // LD L, d8
+    OPCODE(0x2F) a = ~a; f |= FLAG_N | FLAG_H; NEXT(0x2F);                  // CPL
+
+    OPCODE(0x31) sp = D16; NEXT(0x31);                                      // LD SP, d16
+    OPCODE(0x32) m->wb(hl.word, a); hl.word--; NEXT_WRITE(0x32);            // LDD (HL), A
+    OPCODE(0x33) sp++; NEXT(0x33);                                          // INC SP
+    OPCODE(0x34) tmp = m->rb(hl.word); ALU_INC(tmp); m->wb(hl.word, tmp); CHECK_Z(m->rb(hl.word)); NEXT_WRITE(0x34); // INC (HL)
+    OPCODE(0x35) tmp = m->rb(hl.word); ALU_DEC(tmp); m->wb(hl.word, tmp); CHECK_Z(m->rb(hl.word)); NEXT_WRITE(0x35); // DEC (HL)
+    OPCODE(0x36) m->wb(hl.word, D8); NEXT_WRITE(0x36);                      // LD (HL), d8
+    OPCODE(0x37) f = (f & ~(FLAG_N | FLAG_H)) | FLAG_C; NEXT(0x37);         // SCF
+    OPCODE(0x3A) a = m->rb(hl.word); hl.word--; NEXT(0x3A);                 // LDD A, (HL)
+    OPCODE(0x3B) sp--; NEXT(0x3B);                                          // DEC SP
+    OPCODE(0x3C) ALU_INC(a); NEXT(0x3C);                                    // INC A
+    OPCODE(0x3D) ALU_DEC(a); NEXT(0x3D);                                    // DEC A
+    OPCODE(0x3E) a = D8; NEXT(0x3E);                                        // LD A, d8
+    OPCODE(0x3F) f ^= FLAG_C; NEXT(0x3F);                                   // CCF
+    OPCODE(0x40) NEXT(0x40);                                                // LD B, B
+    OPCODE(0x41) b = c; NEXT(0x41);                                         // LD B, C
+    OPCODE(0x42) b = d; NEXT(0x42);                                         // LD B, D
+    OPCODE(0x43) b = e; NEXT(0x43);                                         // LD B, E
+    OPCODE(0x44) b = h; NEXT(0x44);                                         // LD B, H
+    OPCODE(0x45) b = l; NEXT(0x45);                                         // LD B, L
+    OPCODE(0x46) b = m->rb(hl.word); NEXT(0x46);                            // LD B, (HL)
+    OPCODE(0x47) b = a; NEXT(0x47);                                         // LD B, A
+    OPCODE(0x48) c = b; NEXT(0x48);                                         // LD C, B
+    OPCODE(0x49) NEXT(0x49);                                                // LD C, C
+    OPCODE(0x4A) c = d; NEXT(0x4A);                                         // LD C, D
+    OPCODE(0x4B) c = e; NEXT(0x4B);                                         // LD C, E
+    OPCODE(0x4C) c = h; NEXT(0x4C);                                         // LD C, H
+    OPCODE(0x4D) c = l; NEXT(0x4D);                                         // LD C, L
+    OPCODE(0x4E) c = m->rb(hl.word); NEXT(0x4E);                            // LD C, (HL)
+    OPCODE(0x4F) c = a; NEXT(0x4F);                                         // LD C, A
+
+    OPCODE(0x50) d = b; NEXT(0x50);                                         // LD D, B
+    OPCODE(0x51) d = c; NEXT(0x51);                                         // LD D, C
+    OPCODE(0x52) NEXT(0x52);                                                // LD D, D
+    OPCODE(0x53) d = e; NEXT(0x53);                                         // LD D, E
+    OPCODE(0x54) d = h; NEXT(0x54);                                         // LD D, H
+    OPCODE(0x55) d = l; NEXT(0x55);                                         // LD D, L
+    OPCODE(0x56) d = m->rb(hl.word); NEXT(0x56);                            // LD D, (HL)
+    OPCODE(0x57) d = a; NEXT(0x57);                                         // LD D, A
+    OPCODE(0x58) e = b; NEXT(0x58);                                         // LD E, B
+    OPCODE(0x59) e = c; NEXT(0x59);                                         // LD E, C
+    OPCODE(0x5A) e = d; NEXT(0x5A);                                         // LD E, D
+    OPCODE(0x5B) NEXT(0x5B);                                                // LD E, E
+    OPCODE(0x5C) e = h; NEXT(0x5C);                                         // LD E, H
+    OPCODE(0x5D) e = l; NEXT(0x5D);                                         // LD E, L
+    OPCODE(0x5E) e = m->rb(hl.word); NEXT(0x5E);                            // LD E, (HL)
+    OPCODE(0x5F) e = a; NEXT(0x5F);                                         // LD E, A
+
+    OPCODE(0x60) h = b; NEXT(0x60);                                         // LD H, B
+    OPCODE(0x61) h = c; NEXT(0x61);                                         // LD H, C
+    OPCODE(0x62) h = d; NEXT(0x62);                                         // LD H, D
+    OPCODE(0x63) h = e; NEXT(0x63);                                         // LD H, E
+    OPCODE(0x64) NEXT(0x64);                                                // LD H, H
+    OPCODE(0x65) h = l; NEXT(0x65);                                         // LD H, L
+    OPCODE(0x66) h = m->rb(hl.word); NEXT(0x66);                            // LD H, (HL)
+    OPCODE(0x67) h = a; NEXT(0x67);                                         // LD H, A
+    OPCODE(0x68) l = b; NEXT(0x68);                                         // LD L, B
+    OPCODE(0x69) l = c; NEXT(0x69);                                         // LD L, C
+    OPCODE(0x6A) l = d; NEXT(0x6A);                                         // LD L, D
+    OPCODE(0x6B) l = e; NEXT(0x6B);                                         // LD L, E
+    OPCODE(0x6C) l = h; NEXT(0x6C);                                         // LD L, H
+    OPCODE(0x6D) NEXT(0x6D);                                                // LD L, L
+    OPCODE(0x6E) l = m->rb(hl.word); NEXT(0x6E);                            // LD L, (HL)
+    OPCODE(0x6F) l = a; NEXT(0x6F);                                         // LD L, A
+
+    OPCODE(0x70) m->wb(hl.word, b); NEXT_WRITE(0x70);                       // LD (HL), B
+    OPCODE(0x71) m->wb(hl.word, c); NEXT_WRITE(0x71);                       // LD (HL), C
+    OPCODE(0x72) m->wb(hl.word, d); NEXT_WRITE(0x72);                       // LD (HL), D
+    OPCODE(0x73) m->wb(hl.word, e); NEXT_WRITE(0x73);                       // LD (HL), E
+    OPCODE(0x74) m->wb(hl.word, h); NEXT_WRITE(0x74);                       // LD (HL), H
+    OPCODE(0x75) m->wb(hl.word, l); NEXT_WRITE(0x75);                       // LD (HL), L
+    // 0x76 HALT goes through the fallback
+    OPCODE(0x77) m->wb(hl.word, a); NEXT_WRITE(0x77);                       // LD (HL), A
+    OPCODE(0x78) a = b; NEXT(0x78);                                         // LD A, B
+    OPCODE(0x79) a = c; NEXT(0x79);                                         // LD A, C
+    OPCODE(0x7A) a = d; NEXT(0x7A);                                         // LD A, D
+    OPCODE(0x7B) a = e; NEXT(0x7B);                                         // LD A, E
+    OPCODE(0x7C) a = h; NEXT(0x7C);                                         // LD A, H
+    OPCODE(0x7D) a = l; NEXT(0x7D);                                         // LD A, L
+    OPCODE(0x7E) a = m->rb(hl.word); NEXT(0x7E);                            // LD A, (HL)
+    OPCODE(0x7F) NEXT(0x7F);                                                // LD A, A
+
+    OPCODE(0x80) ALU_ADD(b); NEXT(0x80);                                    // ADD A, B
+    OPCODE(0x81) ALU_ADD(c); NEXT(0x81);                                    // ADD A, C
+    OPCODE(0x82) ALU_ADD(d); NEXT(0x82);                                    // ADD A, D
+    OPCODE(0x83) ALU_ADD(e); NEXT(0x83);                                    // ADD A, E
+    OPCODE(0x84) ALU_ADD(h); NEXT(0x84);                                    // ADD A, H
+    OPCODE(0x85) ALU_ADD(l); NEXT(0x85);                                    // ADD A, L
+    OPCODE(0x86) ALU_ADD(m->rb(hl.word)); NEXT(0x86);                       // ADD A, (HL)
+    OPCODE(0x87) ALU_ADD(a); NEXT(0x87);                                    // ADD A, A
+    OPCODE(0x88) ALU_ADC(b); NEXT(0x88);                                    // ADC A, B
+    OPCODE(0x89) ALU_ADC(c); NEXT(0x89);                                    // ADC A, C
+    OPCODE(0x8A) ALU_ADC(d); NEXT(0x8A);                                    // ADC A, D
+    OPCODE(0x8B) ALU_ADC(e); NEXT(0x8B);                                    // ADC A, E
+    OPCODE(0x8C) ALU_ADC(h); NEXT(0x8C);                                    // ADC A, H
+    OPCODE(0x8D) ALU_ADC(l); NEXT(0x8D);                                    // ADC A, L
+    OPCODE(0x8E) ALU_ADC(m->rb(hl.word)); NEXT(0x8E);                       // ADC A, (HL)
+    OPCODE(0x8F) ALU_ADC(a); NEXT(0x8F);                                    // ADC A, A
+
+    OPCODE(0x90) ALU_SUB(b); NEXT(0x90);                                    // SUB B
+    OPCODE(0x91) ALU_SUB(c); NEXT(0x91);                                    // SUB C
+    OPCODE(0x92) ALU_SUB(d); NEXT(0x92);                                    // SUB D
+    OPCODE(0x93) ALU_SUB(e); NEXT(0x93);                                    // SUB E
+    OPCODE(0x94) ALU_SUB(h); NEXT(0x94);                                    // SUB H
+    OPCODE(0x95) ALU_SUB(l); NEXT(0x95);                                    // SUB L
+    OPCODE(0x96) ALU_SUB(m->rb(hl.word)); NEXT(0x96);                       // SUB (HL)
+    OPCODE(0x97) ALU_SUB(a); NEXT(0x97);                                    // SUB A
+    OPCODE(0x98) ALU_SBC(b); NEXT(0x98);                                    // SBC A, B
+    OPCODE(0x99) ALU_SBC(c); NEXT(0x99);                                    // SBC A, C
+    OPCODE(0x9A) ALU_SBC(d); NEXT(0x9A);                                    // SBC A, D
+    OPCODE(0x9B) ALU_SBC(e); NEXT(0x9B);                                    // SBC A, E
+    OPCODE(0x9C) ALU_SBC(h); NEXT(0x9C);                                    // SBC A, H
+    OPCODE(0x9D) ALU_SBC(l); NEXT(0x9D);                                    // SBC A, L
+    OPCODE(0x9E) ALU_SBC(m->rb(hl.word)); NEXT(0x9E);                       // SBC A, (HL)
+    OPCODE(0x9F) ALU_SBC(a); NEXT(0x9F);                                    // SBC A, A
+
+    OPCODE(0xA0) ALU_AND(b); NEXT(0xA0);                                    // AND B
+    OPCODE(0xA1) ALU_AND(c); NEXT(0xA1);                                    // AND C
+    OPCODE(0xA2) ALU_AND(d); NEXT(0xA2);                                    // AND D
+    OPCODE(0xA3) ALU_AND(e); NEXT(0xA3);                                    // AND E
+    OPCODE(0xA4) ALU_AND(h); NEXT(0xA4);                                    // AND H
+    OPCODE(0xA5) ALU_AND(l); NEXT(0xA5);                                    // AND L
+    OPCODE(0xA6) ALU_AND(m->rb(hl.word)); NEXT(0xA6);                       // AND (HL)
+    OPCODE(0xA7) ALU_AND(a); NEXT(0xA7);                                    // AND A
+    OPCODE(0xA8) ALU_XOR(b); NEXT(0xA8);                                    // XOR B
+    OPCODE(0xA9) ALU_XOR(c); NEXT(0xA9);                                    // XOR C
+    OPCODE(0xAA) ALU_XOR(d); NEXT(0xAA);                                    // XOR D
+    OPCODE(0xAB) ALU_XOR(e); NEXT(0xAB);                                    // XOR E
+    OPCODE(0xAC) ALU_XOR(h); NEXT(0xAC);                                    // XOR H
+    OPCODE(0xAD) ALU_XOR(l); NEXT(0xAD);                                    // XOR L
+    OPCODE(0xAE) ALU_XOR(m->rb(hl.word)); NEXT(0xAE);                       // XOR (HL)
+    OPCODE(0xAF) ALU_XOR(a); NEXT(0xAF);                                    // XOR A
+
+    OPCODE(0xB0) ALU_OR(b); NEXT(0xB0);                                     // OR B
+    OPCODE(0xB1) ALU_OR(c); NEXT(0xB1);                                     // OR C
+    OPCODE(0xB2) ALU_OR(d); NEXT(0xB2);                                     // OR D
+    OPCODE(0xB3) ALU_OR(e); NEXT(0xB3);                                     // OR E
+    OPCODE(0xB4) ALU_OR(h); NEXT(0xB4);                                     // OR H
+    OPCODE(0xB5) ALU_OR(l); NEXT(0xB5);                                     // OR L
+    OPCODE(0xB6) ALU_OR(m->rb(hl.word)); NEXT(0xB6);                        // OR (HL)
+    OPCODE(0xB7) ALU_OR(a); NEXT(0xB7);                                     // OR A
+    OPCODE(0xB8) ALU_CP(b); NEXT(0xB8);                                     // CP B
+    OPCODE(0xB9) ALU_CP(c); NEXT(0xB9);                                     // CP C
+    OPCODE(0xBA) ALU_CP(d); NEXT(0xBA);                                     // CP D
+    OPCODE(0xBB) ALU_CP(e); NEXT(0xBB);                                     // CP E
+    OPCODE(0xBC) ALU_CP(h); NEXT(0xBC);                                     // CP H
+    OPCODE(0xBD) ALU_CP(l); NEXT(0xBD);                                     // CP L
+    OPCODE(0xBE) ALU_CP(m->rb(hl.word)); NEXT(0xBE);                        // CP (HL)
+    OPCODE(0xBF) ALU_CP(a); NEXT(0xBF);                                     // CP A
+
+    OPCODE(0xC6) ALU_ADD(D8); NEXT(0xC6);                                   // ADD A, d8
+    OPCODE(0xCE) ALU_ADC(D8); NEXT(0xCE);                                   // ADC A, d8
+    OPCODE(0xD6) ALU_SUB(D8); NEXT(0xD6);                                   // SUB d8
+    OPCODE(0xDE) ALU_SBC(D8); NEXT(0xDE);                                   // SBC A, d8
+    OPCODE(0xE0) m->wb(0xFF00 + D8, a); NEXT_WRITE(0xE0);                   // LDH (a8), A
+    OPCODE(0xE6) ALU_AND(D8); NEXT(0xE6);                                   // AND d8
+    OPCODE(0xEA) m->wb(D16, a); NEXT_WRITE(0xEA);                           // LD (a16), A
+    OPCODE(0xEE) ALU_XOR(D8); NEXT(0xEE);                                   // XOR d8
+    OPCODE(0xF0) a = m->rb(0xFF00 + D8); NEXT(0xF0);                        // LDH A, (a8)
+    OPCODE(0xF6) ALU_OR(D8); NEXT(0xF6);                                    // OR d8
+    OPCODE(0xF9) sp = hl.word; NEXT(0xF9);                                  // LD SP, HL
+    OPCODE(0xFA) a = m->rb(D16); NEXT(0xFA);                                // LD A, (a16)
+    OPCODE(0xFE) ALU_CP(D8); NEXT(0xFE);                                    // CP d8
+
+#ifndef GB_COMPUTED_GOTO
+    default:
+        goto fallback;
+    }
+#endif
+
+fallback:
+    STORE_REGISTERS();
+
+    last_opcode_not_executed = false;
+    current_opcode = &opcodes_table[op];
+    fetch_operand();
+
+    (this->*(current_opcode->exec))();
+
+    PC += current_opcode->length;
+    elapsed += last_opcode_not_executed ? current_opcode->not_exec_cycles : current_opcode->cycles;
+
+    LOAD_REGISTERS();
+
+    if(HALT || STOP || m->dma_active()) return elapsed;
+
+    DISPATCH();
+
+done:
+    STORE_REGISTERS();
+
+    return elapsed;
+
+#undef LOAD_REGISTERS
+#undef STORE_REGISTERS
+#undef a
+#undef f
+#undef b
+#undef c
+#undef d
+#undef e
+#undef h
+#undef l
+#undef D8
+#undef D16
+#undef SET_FLAGS
+#undef CHECK_Z
+#undef ALU_ADD
+#undef ALU_ADC
+#undef ALU_SUB
+#undef ALU_SBC
+#undef ALU_AND
+#undef ALU_XOR
+#undef ALU_OR
+#undef ALU_CP
+#undef ALU_INC
+#undef ALU_DEC
+#undef NEXT
+#undef NEXT_WRITE
+#undef OPCODE
+#undef DISPATCH
+#undef GB_COMPUTED_GOTO
+}
+
+/////////////////////////////////////
+// BLOCK CACHE
+/////////////////////////////////////
+
+/* Opcodes after which a block stops : jumps, calls, returns, HALT, STOP, and DI / EI so that
+ * interrupts can be handled between blocks. Not implemented opcodes end it as well.
+ */
+static bool ends_block(quint8 opcode)
+{
+    switch(opcode)
+    {
+    case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: case 0x76:
+    case 0xC0: case 0xC2: case 0xC3: case 0xC4: case 0xC7: case 0xC8: case 0xC9: case 0xCA: case 0xCC: case 0xCD: case 0xCF:
+    case 0xD0: case 0xD2: case 0xD3: case 0xD4: case 0xD7: case 0xD8: case 0xD9: case 0xDA: case 0xDB: case 0xDC: case 0xDD: case 0xDF:
+    case 0xE3: case 0xE4: case 0xE7: case 0xE9: case 0xEB: case 0xEC: case 0xED: case 0xEF:
+    case 0xF3: case 0xF4: case 0xF7: case 0xFB: case 0xFC: case 0xFD: case 0xFF:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/* Superinstruction made of the given opcodes, or NULL */
+const cpu::opcode* cpu::find_fused(quint8 first, quint8 second)
+{
+    for(quint8 i = 0 ; i < FUSED_OPCODES_COUNT ; ++i)
+    {
+        if(fused_opcodes_table[i].first == first && fused_opcodes_table[i].second == second)
+            return &fused_opcodes_table[i].op;
+    }
+
+    return NULL;
+}
+
+bool cpu::is_fused(const opcode* op)
+{
+    for(quint8 i = 0 ; i < FUSED_OPCODES_COUNT ; ++i)
+    {
+        if(op == &fused_opcodes_table[i].op) return true;
+    }
+
+    return false;
+}
+
+#ifdef GB_BLOCK_CACHE
+
+/* Alternative execution used by run_for() when built with GB_BLOCK_CACHE.
+ *
+ * The code at PC is decoded once into a block : opcode entries with their immediate values
+ * already read, and the total cycles. A block is cached until a write into its page, which
+ * also covers self-modifying code and, through mmu::page_writes(), bank switches.
+ *
+ * Returns the number of cycles elapsed, or 0 if PC is not in cacheable memory or the block
+ * does not fit in the given cycles, in which case the caller steps opcode by opcode.
+ */
+quint32 cpu::run_block(quint32 cycles)
+{
+    block* b = &blocks[PC & (BLOCK_CACHE_SIZE - 1)];
+    const quint32* writes = memory.page_writes(PC);
+
+    if(!b->count || b->address != PC || b->writes != *writes)
+    {
+        if(!decode_block(b)) return 0;
+    }
+
+    if(b->cycles > cycles) return 0;
+
+    return execute_block(b, writes);
+}
+
+#endif // GB_BLOCK_CACHE
+
+/* Execute a decoded block starting at PC. writes is the writes counter of its page : if the
+ * block writes into its own page, it stops after that opcode since the following ones may
+ * have changed.
+ *
+ * Returns the number of cycles elapsed.
+ */
+quint32 cpu::execute_block(const block* b, const quint32* writes)
+{
+    last_opcode_not_executed = false;
+
+    for(quint8 i = 0 ; i < b->count ; ++i)
+    {
+        current_opcode = b->opcodes[i].op;
+        operand = b->opcodes[i].operand;
+
+        (this->*(current_opcode->exec))();
+
+        PC += current_opcode->length;
+
+        //the block wrote into its own page, the following opcodes may have changed
+        if(*writes != b->writes && i + 1 < b->count)
+        {
+            quint32 elapsed = 0;
+
+            for(quint8 j = 0 ; j <= i ; ++j)
+                elapsed += b->opcodes[j].op->cycles;
+
+            return elapsed;
+        }
+    }
+
+    return last_opcode_not_executed ? b->not_exec_cycles : b->cycles;
+}
+
+/* Decode the block starting at PC. Blocks never cross a page, so that a single writes counter
+ * tells whether they are still valid.
+ *
+ * Returns false if PC is not in memory mmu::page() gives a direct access to.
+ */
+bool cpu::decode_block(block* b)
+{
+    const quint8* page = memory.page(PC);
+
+    if(!page) return false;
+
+    quint16 offset = PC & 0xFF;
+
+    b->count = 0;
+    b->cycles = 0;
+
+    while(b->count < BLOCK_MAX_OPCODES)
+    {
+        quint8 code = page[offset];
+        const opcode* op = &opcodes_table[code];
+
+        if(code == 0xCB)
+        {
+            if(offset + 1 > 0xFF) break;
+
+            op = &extended_opcodes_table[page[offset + 1]];
+        }
+
+        if(offset + op->length > 0x100) break;
+
+        decoded_opcode& decoded = b->opcodes[b->count++];
+
+        decoded.op = op;
+        decoded.operand = 0;
+        decoded.code = code;
+
+        if(op->length > 1) decoded.operand = page[offset + 1];
+        if(op->length > 2) decoded.operand += page[offset + 2] << 8;
+
+        //the opcode and the next one make a superinstruction
+        if(code != 0xCB && offset + op->length < 0x100)
+        {
+            quint8 second = page[offset + op->length];
+            const opcode* fused = find_fused(code, second);
+
+            if(fused && offset + fused->length <= 0x100)
+            {
+                quint8 shift = (op->length - 1) * 8;
+
+                if(fused->length - op->length > 1) decoded.operand += page[offset + op->length + 1] << shift;
+                if(fused->length - op->length > 2) decoded.operand += page[offset + op->length + 2] << (shift + 8);
+
+                decoded.op = op = fused;
+                code = second;
+            }
+        }
+
+        b->cycles += op->cycles;
+        offset += op->length;
+
+        if(ends_block(code)) break;
+    }
+
+    if(!b->count) return false;
+
+    const opcode* last = b->opcodes[b->count - 1].op;
+
+    b->address = PC;
+    b->not_exec_cycles = b->cycles - last->cycles + last->not_exec_cycles;
+    b->writes = *memory.page_writes(PC);
+
+    return true;
+}
+
+
+/////////////////////////////////////
+// OPCODE FUNCTIONS
+/////////////////////////////////////
+
+void cpu::not_impl()
+{
+    std::cerr << "Opcode not implemented" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/* 0x00 NOP : No Operation
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::nop()
+{
+
+}
+
+/* 0x01 LD BC, d16 : Load 16-bit immediate into BC
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::ld_bc_d16()
+{
+    _BC = _d16;
+}
+
+/* 0x02 LD (BC), A : Save A to address pointed by BC
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::ld_bc_a()
+{
+    memory.wb(_BC, _A);
+}
+
+/* 0x03 INC BC : Increment 16-bit BC
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::inc_bc()
+{
+    _BC++;
+}
+
+/* 0x04 INC B : Increment B
+ *
+ * Flags affected:
+ * Z - Set if result is zero.
+ * N - Reset.
+ * H - Set if carry from bit 3.
+ * C - Not affected.
+ */
+void cpu::inc_b()
+{
+    alu_inc(_B);
+}
+
+/* 0x05 DEC B : Decrement B
+ *
+ * Flags affected:
+ * Z - Set if result is zero.
+ * N - Set.
+ * H - Set if no borrow from bit 4.
+ * C - Not affected.
+ */
+void cpu::dec_b()
+{
+    alu_dec(_B);
+}
+
+/* 0x06 LD B, d8 : Load 8-bit immediate into B
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::ld_b_d8()
+{
+    _B = _d8;
+}
+
+/* 0x07 RLCA : Rotate A left. Old bit 7 to Carry flag.
+ *
+ * Flags affected:
+ * Z - Reset.
+ * N - Reset.
+ * H - Reset.
+ * C - Contains old bit 7 data.
+ */
+void cpu::rlca()
+{
+    reset_z();
+    reset_n();
+    reset_h();
+
+    check_c_rl(_A);
+
+    _A = ( (_A & 0x80) ? (_A << 1) + 1 : (_A << 1) );
+
+
+}
+
+/* 0x08 LD (a16), SP : Save SP to given address
+ *
+ * Flags affected:
+ * None
+ */
+void cpu::ld_a16_sp()
+{
+    memory.ww(_a16, SP);
 }
 
 /* 0x09 ADD HL, BC : Add BC to HL.
@@ -833,7 +2090,7 @@ void cpu::add_hl_bc()
     check_h_add16(_HL, _BC);
     check_c_add16(_HL, _BC);
 
-    write_on_register(REGISTER_HL, _HL + _BC);
+    _HL += _BC;
 }
 
 /* 0x0A LD A, (BC) : Load A from address pointed to by BC
@@ -843,7 +2100,7 @@ void cpu::add_hl_bc()
  */
 void cpu::ld_a_bc()
 {
-    _A = _MMU->rb(_BC);
+    _A = memory.rb(_BC);
 }
 
 /* 0x0B DEC BC : Decrement 16-bit BC
@@ -853,8 +2110,7 @@ void cpu::ld_a_bc()
  */
 void cpu::dec_bc()
 {
-    _C--;
-    if(_C == 0xFF) _B--;
+    _BC--;
 }
 
 /* 0x0C INC C : Increment C
@@ -867,12 +2123,7 @@ void cpu::dec_bc()
  */
 void cpu::inc_c()
 {
-    check_h_add8(_C, 1);
-
-    _C++;
-
-    check_z(_C);
-    reset_n();
+    alu_inc(_C);
 }
 
 /* 0x0D DEC C : Decrement C
@@ -885,12 +2136,7 @@ void cpu::inc_c()
  */
 void cpu::dec_c()
 {
-    check_h_sub8(_C, 1);
-
-    _C--;
-
-    check_z(_C);
-    set_n();
+    alu_dec(_C);
 }
 
 /* 0x0E LD C, d8 : Load 8-bit immediate into C
@@ -942,7 +2188,7 @@ void cpu::stop()
  */
 void cpu::ld_de_d16()
 {
-    write_on_register(REGISTER_DE, _d16);
+    _DE = _d16;
 }
 
 /* 0x12 LD (DE), A : Save A to address pointed by DE
@@ -952,7 +2198,7 @@ void cpu::ld_de_d16()
  */
 void cpu::ld_de_a()
 {
-    _MMU->wb(_DE, _A);
+    memory.wb(_DE, _A);
 }
 
 /* 0x13 INC DE : Increment 16-bit DE
@@ -962,8 +2208,7 @@ void cpu::ld_de_a()
  */
 void cpu::inc_de()
 {
-    _E++;
-    if(!_E) _D++;
+    _DE++;
 }
 
 /* 0x14 INC D : Increment D
@@ -976,12 +2221,7 @@ void cpu::inc_de()
  */
 void cpu::inc_d()
 {
-    check_h_add8(_D, 1);
-
-    _D++;
-
-    check_z(_D);
-    reset_n();
+    alu_inc(_D);
 }
 
 /* 0x15 DEC D : Decrement D
@@ -994,12 +2234,7 @@ void cpu::inc_d()
  */
 void cpu::dec_d()
 {
-    check_h_sub8(_D, 1);
-
-    _D--;
-
-    check_z(_D);
-    set_n();
+    alu_dec(_D);
 }
 
 /* 0x16 LD D, d8 : Load 8-bit immediate into D
@@ -1059,7 +2294,7 @@ void cpu::add_hl_de()
     check_h_add16(_HL, _DE);
     check_c_add16(_HL, _DE);
 
-    write_on_register(REGISTER_HL, _HL + _DE);
+    _HL += _DE;
 }
 
 /* 0x1A LD A, (DE) : Load A from address pointed to by DE
@@ -1069,7 +2304,7 @@ void cpu::add_hl_de()
  */
 void cpu::ld_a_de()
 {
-    _A = _MMU->rb(_DE);
+    _A = memory.rb(_DE);
 }
 
 /* 0x1B DEC DE : Decrement 16-bit DE
@@ -1079,8 +2314,7 @@ void cpu::ld_a_de()
  */
 void cpu::dec_de()
 {
-    _E--;
-    if(_E == 0xFF) _D--;
+    _DE--;
 }
 
 /* 0x1C INC E : Increment E
@@ -1093,12 +2327,7 @@ void cpu::dec_de()
  */
 void cpu::inc_e()
 {
-    check_h_add8(_E, 1);
-
-    _E++;
-
-    check_z(_E);
-    reset_n();
+    alu_inc(_E);
 }
 
 /* 0x1D DEC E : Decrement E
@@ -1111,12 +2340,7 @@ void cpu::inc_e()
  */
 void cpu::dec_e()
 {
-    check_h_sub8(_E, 1);
-
-    _E--;
-
-    check_z(_E);
-    set_n();
+    alu_dec(_E);
 }
 
 /* 0x1E LD E, d8 : Load 8-bit immediate into E
@@ -1175,7 +2399,7 @@ void cpu::jr_nz_r8()
  */
 void cpu::ld_hl_d16()
 {
-    write_on_register(REGISTER_HL, _d16);
+    _HL = _d16;
 }
 
 /* 0x22 LDI (HL), A : Save A to address pointed by HL, and increment HL
@@ -1185,7 +2409,7 @@ void cpu::ld_hl_d16()
  */
 void cpu::ldi_hl_a()
 {
-    _MMU->wb(_HL, _A);
+    memory.wb(_HL, _A);
     inc_hl();
 }
 
@@ -1196,8 +2420,7 @@ void cpu::ldi_hl_a()
  */
 void cpu::inc_hl()
 {
-    _L++;
-    if(!_L) _H++;
+    _HL++;
 }
 
 /* 0x24 INC H : Increment H
@@ -1210,12 +2433,7 @@ void cpu::inc_hl()
  */
 void cpu::inc_h()
 {
-    check_h_add8(_H, 1);
-
-    _H++;
-
-    check_z(_H);
-    reset_n();
+    alu_inc(_H);
 }
 
 /* 0x25 DEC H : Decrement H
@@ -1228,12 +2446,7 @@ void cpu::inc_h()
  */
 void cpu::dec_h()
 {
-    check_h_sub8(_H, 1);
-
-    _H--;
-
-    check_z(_H);
-    set_n();
+    alu_dec(_H);
 }
 
 /* 0x26 LD H, d8 : Load 8-bit immediate into H
@@ -1257,7 +2470,29 @@ void cpu::ld_h_d8()
  */
 void cpu::daa()
 {
+    //N, H and C of the last addition or subtraction drive the adjustment
+    sync_flags();
+
+    quint8 correction = 0;
+    bool carry = c_flag();
+
+    if(h_flag() || (!n_flag() && (_A & 0x0F) > 0x09))
+        correction |= 0x06;
+
+    if(carry || (!n_flag() && _A > 0x99))
+    {
+        correction |= 0x60;
+        carry = true;
+    }
+
+    if(n_flag()) _A -= correction;
+    else _A += correction;
+
+    check_z(_A);
+    reset_h();
 
+    if(carry) set_c();
+    else reset_c();
 }
 
 /* 0x28 JR Z, r8 : Relative jump by signed immediate if last result was zero.
@@ -1290,7 +2525,7 @@ void cpu::add_hl_hl()
     check_h_add16(_HL, _HL);
     check_c_add16(_HL, _HL);
 
-    write_on_register(REGISTER_HL, _HL + _HL);
+    _HL += _HL;
 }
 
 /* 0x2A LDI A, (HL) : Load A from address pointed to by HL, and increment HL
@@ -1300,7 +2535,7 @@ void cpu::add_hl_hl()
  */
 void cpu::ldi_a_hl()
 {
-    _A = _MMU->rb(_HL);
+    _A = memory.rb(_HL);
     inc_hl();
 }
 
@@ -1311,8 +2546,7 @@ void cpu::ldi_a_hl()
  */
 void cpu::dec_hl()
 {
-    _L--;
-    if(_L == 0xFF) _H--;
+    _HL--;
 }
 
 /* 0x2C INC L : Increment L
@@ -1325,12 +2559,7 @@ void cpu::dec_hl()
  */
 void cpu::inc_l()
 {
-    check_h_add8(_L, 1);
-
-    _L++;
-
-    check_z(_L);
-    reset_n();
+    alu_inc(_L);
 }
 
 /* 0x2D DEC L : Decrement L
@@ -1343,12 +2572,7 @@ void cpu::inc_l()
  */
 void cpu::dec_l()
 {
-    check_h_sub8(_L, 1);
-
-    _L--;
-
-    check_z(_L);
-    set_n();
+    alu_dec(_L);
 }
 
 /* 0x2E LD L, d8 : Load 8-bit immediate into L
@@ -1411,7 +2635,7 @@ void cpu::ld_sp_d16()
  */
 void cpu::ldd_hl_a()
 {
-    _MMU->wb(_HL, _A);
+    memory.wb(_HL, _A);
     dec_hl();
 }
 
@@ -1435,11 +2659,11 @@ void cpu::inc_sp()
  */
 void cpu::inc_hl_()
 {
-    check_h_add8(_MMU->rb(_HL), 1);
+    check_h_add8(memory.rb(_HL), 1);
 
-    _MMU->wb(_HL, _MMU->rb(_HL) + 1);
+    memory.wb(_HL, memory.rb(_HL) + 1);
 
-    check_z(_MMU->rb(_HL));
+    check_z(memory.rb(_HL));
     reset_n();
 }
 
@@ -1453,11 +2677,11 @@ void cpu::inc_hl_()
  */
 void cpu::dec_hl_()
 {
-    check_h_sub8(_MMU->rb(_HL), 1);
+    check_h_sub8(memory.rb(_HL), 1);
 
-    _MMU->wb(_HL, _MMU->rb(_HL) - 1);
+    memory.wb(_HL, memory.rb(_HL) - 1);
 
-    check_z(_MMU->rb(_HL));
+    check_z(memory.rb(_HL));
     set_n();
 }
 
@@ -1468,7 +2692,7 @@ void cpu::dec_hl_()
   */
 void cpu::ld_hl_d8()
 {
-    _MMU->wb(_HL, _d8);
+    memory.wb(_HL, _d8);
 }
 
 /* 0x37 SCF : Set carry flag
@@ -1513,10 +2737,10 @@ void cpu::jr_c_r8()
 void cpu::add_hl_sp()
 {
     reset_n();
-    check_h_add16(_HL, _SP);
-    check_c_add16(_HL, _SP);
+    check_h_add16(_HL, SP);
+    check_c_add16(_HL, SP);
 
-    write_on_register(REGISTER_HL, _HL + _SP);
+    _HL += SP;
 }
 
 /* 0x3A LDD A, (HL) : Load A from address pointed to by HL, and decrement HL
@@ -1526,7 +2750,7 @@ void cpu::add_hl_sp()
  */
 void cpu::ldd_a_hl()
 {
-    _A = _MMU->rb(_HL);
+    _A = memory.rb(_HL);
     dec_hl();
 }
 
@@ -1550,12 +2774,7 @@ void cpu::dec_sp()
  */
 void cpu::inc_a()
 {
-    check_h_add8(_A, 1);
-
-    _A++;
-
-    check_z(_A);
-    reset_n();
+    alu_inc(_A);
 }
 
 /* 0x3D DEC A : Decrement A
@@ -1568,12 +2787,7 @@ void cpu::inc_a()
  */
 void cpu::dec_a()
 {
-    check_h_sub8(_A, 1);
-
-    _A--;
-
-    check_z(_A);
-    set_n();
+    alu_dec(_A);
 }
 
 /* 0x3E LD A, d8 : Load 8-bit immediate into A
@@ -1668,7 +2882,7 @@ void cpu::ld_b_l()
  */
 void cpu::ld_b_hl()
 {
-    _B = _MMU->rb(_HL);
+    _B = memory.rb(_HL);
 }
 
 /* 0x47 LD B, A : Copy A to B
@@ -1748,7 +2962,7 @@ void cpu::ld_c_l()
  */
 void cpu::ld_c_hl()
 {
-    _C = _MMU->rb(_HL);
+    _C = memory.rb(_HL);
 }
 
 /* 0x4F LD C, A : Copy A to C
@@ -1829,7 +3043,7 @@ void cpu::ld_d_l()
  */
 void cpu::ld_d_hl()
 {
-    _D = _MMU->rb(_HL);
+    _D = memory.rb(_HL);
 }
 
 /* 0x57 LD D, A : Copy A to D
@@ -1909,7 +3123,7 @@ void cpu::ld_e_l()
  */
 void cpu::ld_e_hl()
 {
-    _E = _MMU->rb(_HL);
+    _E = memory.rb(_HL);
 }
 
 /* 0x5F LD E, A : Copy A to E
@@ -1990,7 +3204,7 @@ void cpu::ld_h_l()
  */
 void cpu::ld_h_hl()
 {
-    _H = _MMU->rb(_HL);
+    _H = memory.rb(_HL);
 }
 
 /* 0x67 LD H, A : Copy A to H
@@ -2070,7 +3284,7 @@ void cpu::ld_l_l()
  */
 void cpu::ld_l_hl()
 {
-    _L = _MMU->rb(_HL);
+    _L = memory.rb(_HL);
 }
 
 /* 0x6F LD L, A : Copy A to L
@@ -2092,7 +3306,7 @@ void cpu::ld_l_a()
  */
 void cpu::ld_hl_b()
 {
-    _MMU->wb(_HL, _B);
+    memory.wb(_HL, _B);
 }
 
 /* 0x71 LD (HL), C : Copy C to address pointed by HL
@@ -2102,7 +3316,7 @@ void cpu::ld_hl_b()
  */
 void cpu::ld_hl_c()
 {
-    _MMU->wb(_HL, _C);
+    memory.wb(_HL, _C);
 }
 
 /* 0x72 LD (HL), D : Copy D to address pointed by HL
@@ -2112,7 +3326,7 @@ void cpu::ld_hl_c()
  */
 void cpu::ld_hl_d()
 {
-    _MMU->wb(_HL, _D);
+    memory.wb(_HL, _D);
 }
 
 /* 0x73 LD (HL), E : Copy E to address pointed by HL
@@ -2122,7 +3336,7 @@ void cpu::ld_hl_d()
  */
 void cpu::ld_hl_e()
 {
-    _MMU->wb(_HL, _E);
+    memory.wb(_HL, _E);
 }
 
 /* 0x74 LD (HL), H : Copy H to address pointed by HL
@@ -2132,7 +3346,7 @@ void cpu::ld_hl_e()
  */
 void cpu::ld_hl_h()
 {
-    _MMU->wb(_HL, _H);
+    memory.wb(_HL, _H);
 }
 
 /* 0x75 LD (HL), L : Copy L to address pointed by HL
@@ -2142,7 +3356,7 @@ void cpu::ld_hl_h()
  */
 void cpu::ld_hl_l()
 {
-    _MMU->wb(_HL, _L);
+    memory.wb(_HL, _L);
 }
 
 /* 0x76 HALT : Power down CPU until an interrupt occurs
@@ -2162,7 +3376,7 @@ void cpu::halt()
  */
 void cpu::ld_hl_a()
 {
-    _MMU->wb(_HL, _A);
+    memory.wb(_HL, _A);
 }
 
 /* 0x78 LD A, B : Copy B to A
@@ -2232,7 +3446,7 @@ void cpu::ld_a_l()
  */
 void cpu::ld_a_hl()
 {
-    _A = _MMU->rb(_HL);
+    _A = memory.rb(_HL);
 }
 
 /* 0x7F LD A, A : Copy A to A
@@ -2257,14 +3471,7 @@ void cpu::ld_a_a()
  */
 void cpu::add_a_b()
 {
-    reset_n();
-
-    check_h_add8(_A, _B);
-    check_c_add8(_A, _B);
-
-    _A += _B;
-
-    check_z(_A);
+    alu_add(_B);
 }
 
 /* 0x81 ADD A, C : Add C to A
@@ -2277,14 +3484,7 @@ void cpu::add_a_b()
  */
 void cpu::add_a_c()
 {
-    reset_n();
-
-    check_h_add8(_A, _C);
-    check_c_add8(_A, _C);
-
-    _A += _C;
-
-    check_z(_A);
+    alu_add(_C);
 }
 
 /* 0x82 ADD A, D : Add D to A
@@ -2297,14 +3497,7 @@ void cpu::add_a_c()
  */
 void cpu::add_a_d()
 {
-    reset_n();
-
-    check_h_add8(_A, _D);
-    check_c_add8(_A, _D);
-
-    _A += _D;
-
-    check_z(_A);
+    alu_add(_D);
 }
 
 /* 0x83 ADD A, E : Add E to A
@@ -2317,14 +3510,7 @@ void cpu::add_a_d()
  */
 void cpu::add_a_e()
 {
-    reset_n();
-
-    check_h_add8(_A, _E);
-    check_c_add8(_A, _E);
-
-    _A += _E;
-
-    check_z(_A);
+    alu_add(_E);
 }
 
 /* 0x84 ADD A, H : Add H to A
@@ -2337,14 +3523,7 @@ void cpu::add_a_e()
  */
 void cpu::add_a_h()
 {
-    reset_n();
-
-    check_h_add8(_A, _H);
-    check_c_add8(_A, _H);
-
-    _A += _H;
-
-    check_z(_A);
+    alu_add(_H);
 }
 
 /* 0x85 ADD A, L : Add L to A
@@ -2357,14 +3536,7 @@ void cpu::add_a_h()
  */
 void cpu::add_a_l()
 {
-    reset_n();
-
-    check_h_add8(_A, _L);
-    check_c_add8(_A, _L);
-
-    _A += _L;
-
-    check_z(_A);
+    alu_add(_L);
 }
 
 /* 0x86 ADD A, (HL) : Add value pointed by HL to A
@@ -2377,15 +3549,7 @@ void cpu::add_a_l()
  */
 void cpu::add_a_hl()
 {
-    reset_n();
-
-    quint8 val = _MMU->rb(_HL);
-    check_h_add8(_A, val);
-    check_c_add8(_A, val);
-
-    _A += val;
-
-    check_z(_A);
+    alu_add(memory.rb(_HL));
 }
 
 /* 0x87 ADD A, A : Add A to A
@@ -2398,14 +3562,7 @@ void cpu::add_a_hl()
  */
 void cpu::add_a_a()
 {
-    reset_n();
-
-    check_h_add8(_A, _A);
-    check_c_add8(_A, _A);
-
-    _A += _A;
-
-    check_z(_A);
+    alu_add(_A);
 }
 
 /* 0x88 ADC A, B : Add B and carry flag to A
@@ -2418,16 +3575,7 @@ void cpu::add_a_a()
  */
 void cpu::adc_a_b()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _B + cf);
-    check_c_add8(_A, _B + cf);
-
-    _A += (_B + cf);
-
-    check_z(_A);
+    alu_adc(_B);
 }
 
 /* 0x89 ADC A, C : Add C and carry flag to A
@@ -2440,16 +3588,7 @@ void cpu::adc_a_b()
  */
 void cpu::adc_a_c()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _C + cf);
-    check_c_add8(_A, _C + cf);
-
-    _A += (_C + cf);
-
-    check_z(_A);
+    alu_adc(_C);
 }
 
 /* 0x8A ADC A, D : Add D and carry flag to A
@@ -2462,16 +3601,7 @@ void cpu::adc_a_c()
  */
 void cpu::adc_a_d()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _D + cf);
-    check_c_add8(_A, _D + cf);
-
-    _A += (_D + cf);
-
-    check_z(_A);
+    alu_adc(_D);
 }
 
 /* 0x8B ADC A, E : Add E and carry flag to A
@@ -2484,16 +3614,7 @@ void cpu::adc_a_d()
  */
 void cpu::adc_a_e()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _E + cf);
-    check_c_add8(_A, _E + cf);
-
-    _A += (_E + cf);
-
-    check_z(_A);
+    alu_adc(_E);
 }
 
 /* 0x8C ADC A, H : Add H and carry flag to A
@@ -2506,16 +3627,7 @@ void cpu::adc_a_e()
  */
 void cpu::adc_a_h()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _H + cf);
-    check_c_add8(_A, _H + cf);
-
-    _A += (_H + cf);
-
-    check_z(_A);
+    alu_adc(_H);
 }
 
 /* 0x8D ADC A, L : Add L and carry flag to A
@@ -2528,16 +3640,7 @@ void cpu::adc_a_h()
  */
 void cpu::adc_a_l()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _L + cf);
-    check_c_add8(_A, _L + cf);
-
-    _A += (_L + cf);
-
-    check_z(_A);
+    alu_adc(_L);
 }
 
 /* 0x8E ADC A, (HL) : Add value pointed by HL and carry flag to A
@@ -2550,17 +3653,7 @@ void cpu::adc_a_l()
  */
 void cpu::adc_a_hl()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-
-    check_h_add8(_A, val + cf);
-    check_c_add8(_A, val + cf);
-
-    _A += (val + cf);
-
-    check_z(_A);
+    alu_adc(memory.rb(_HL));
 }
 
 /* 0x8F ADC A, A : Add A and carry flag to A
@@ -2573,16 +3666,7 @@ void cpu::adc_a_hl()
  */
 void cpu::adc_a_a()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    reset_n();
-
-    check_h_add8(_A, _A + cf);
-    check_c_add8(_A, _A + cf);
-
-    _A += (_A + cf);
-
-    check_z(_A);
+    alu_adc(_A);
 }
 
 
@@ -2596,13 +3680,7 @@ void cpu::adc_a_a()
  */
 void cpu::sub_b()
 {
-    set_n();
-    check_h_sub8(_A, _B);
-    check_c_sub8(_A, _B);
-
-    _A -= _B;
-
-    check_z(_A);
+    alu_sub(_B);
 }
 
 /* 0x91 SUB C : Subtract C from A
@@ -2615,13 +3693,7 @@ void cpu::sub_b()
  */
 void cpu::sub_c()
 {
-    set_n();
-    check_h_sub8(_A, _C);
-    check_c_sub8(_A, _C);
-
-    _A -= _C;
-
-    check_z(_A);
+    alu_sub(_C);
 }
 
 /* 0x92 SUB D : Subtract D from A
@@ -2634,13 +3706,7 @@ void cpu::sub_c()
  */
 void cpu::sub_d()
 {
-    set_n();
-    check_h_sub8(_A, _D);
-    check_c_sub8(_A, _D);
-
-    _A -= _D;
-
-    check_z(_A);
+    alu_sub(_D);
 }
 
 /* 0x93 SUB E : Subtract E from A
@@ -2653,13 +3719,7 @@ void cpu::sub_d()
  */
 void cpu::sub_e()
 {
-    set_n();
-    check_h_sub8(_A, _E);
-    check_c_sub8(_A, _E);
-
-    _A -= _E;
-
-    check_z(_A);
+    alu_sub(_E);
 }
 
 /* 0x94 SUB H : Subtract H from A
@@ -2672,13 +3732,7 @@ void cpu::sub_e()
  */
 void cpu::sub_h()
 {
-    set_n();
-    check_h_sub8(_A, _H);
-    check_c_sub8(_A, _H);
-
-    _A -= _H;
-
-    check_z(_A);
+    alu_sub(_H);
 }
 
 /* 0x95 SUB L : Subtract L from A
@@ -2691,13 +3745,7 @@ void cpu::sub_h()
  */
 void cpu::sub_l()
 {
-    set_n();
-    check_h_sub8(_A, _L);
-    check_c_sub8(_A, _L);
-
-    _A -= _L;
-
-    check_z(_A);
+    alu_sub(_L);
 }
 
 /* 0x96 SUB (HL) : Subtract value pointed by HL from A
@@ -2710,15 +3758,7 @@ void cpu::sub_l()
  */
 void cpu::sub_hl()
 {
-    quint8 val = _MMU->rb(_HL);
-
-    set_n();
-    check_h_sub8(_A, val);
-    check_c_sub8(_A, val);
-
-    _A -= val;
-
-    check_z(_A);
+    alu_sub(memory.rb(_HL));
 }
 
 /* 0x97 SUB A : Subtract A from A
@@ -2731,13 +3771,7 @@ void cpu::sub_hl()
  */
 void cpu::sub_a()
 {
-    set_n();
-    check_h_sub8(_A, _A);
-    check_c_sub8(_A, _A);
-
-    _A -= _A;
-
-    check_z(_A);
+    alu_sub(_A);
 }
 
 /* 0x98 SBC A, B : Subtract B and carry flag from A
@@ -2750,15 +3784,7 @@ void cpu::sub_a()
  */
 void cpu::sbc_a_b()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _B + cf);
-    check_c_sub8(_A, _B + cf);
-
-    _A -= (_B + cf);
-
-    check_z(_A);
+    alu_sbc(_B);
 }
 
 /* 0x99 SBC A, C : Subtract C and carry flag from A
@@ -2771,15 +3797,7 @@ void cpu::sbc_a_b()
  */
 void cpu::sbc_a_c()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _C + cf);
-    check_c_sub8(_A, _C + cf);
-
-    _A -= (_C + cf);
-
-    check_z(_A);
+    alu_sbc(_C);
 }
 
 /* 0x9A SBC A, D : Subtract D and carry flag from A
@@ -2792,15 +3810,7 @@ void cpu::sbc_a_c()
  */
 void cpu::sbc_a_d()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _D + cf);
-    check_c_sub8(_A, _D + cf);
-
-    _A -= (_D + cf);
-
-    check_z(_A);
+    alu_sbc(_D);
 }
 
 /* 0x9B SBC A, E : Subtract E and carry flag from A
@@ -2813,15 +3823,7 @@ void cpu::sbc_a_d()
  */
 void cpu::sbc_a_e()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _E + cf);
-    check_c_sub8(_A, _E + cf);
-
-    _A -= (_E + cf);
-
-    check_z(_A);
+    alu_sbc(_E);
 }
 
 /* 0x9C SBC A, H : Subtract H and carry flag from A
@@ -2834,15 +3836,7 @@ void cpu::sbc_a_e()
  */
 void cpu::sbc_a_h()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _H + cf);
-    check_c_sub8(_A, _H + cf);
-
-    _A -= (_H + cf);
-
-    check_z(_A);
+    alu_sbc(_H);
 }
 
 /* 0x9D SBC A, L : Subtract L and carry flag from A
@@ -2855,15 +3849,7 @@ void cpu::sbc_a_h()
  */
 void cpu::sbc_a_l()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _L + cf);
-    check_c_sub8(_A, _L + cf);
-
-    _A -= (_L + cf);
-
-    check_z(_A);
+    alu_sbc(_L);
 }
 
 /* 0x9E SBC A, (HL) : Subtract value pointed by HL and carry flag from A
@@ -2876,16 +3862,7 @@ void cpu::sbc_a_l()
  */
 void cpu::sbc_a_hl()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-    quint8 val = _MMU->rb(_HL);
-
-    set_n();
-    check_h_sub8(_A, val + cf);
-    check_c_sub8(_A, val + cf);
-
-    _A -= (val + cf);
-
-    check_z(_A);
+    alu_sbc(memory.rb(_HL));
 }
 
 /* 0x9F SBC A, A : Subtract A and carry flag from A
@@ -2898,15 +3875,7 @@ void cpu::sbc_a_hl()
  */
 void cpu::sbc_a_a()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, _A + cf);
-    check_c_sub8(_A, _A + cf);
-
-    _A -= (_A + cf);
-
-    check_z(_A);
+    alu_sbc(_A);
 }
 
 
@@ -2921,13 +3890,7 @@ void cpu::sbc_a_a()
  */
 void cpu::and_b()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _B;
-
-    check_z(_A);
+    alu_and(_B);
 }
 
 /* 0xA1 AND C : Logical AND between A and C. Result in A
@@ -2940,13 +3903,7 @@ void cpu::and_b()
  */
 void cpu::and_c()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _C;
-
-    check_z(_A);
+    alu_and(_C);
 }
 
 /* 0xA2 AND D : Logical AND between A and D. Result in A
@@ -2959,13 +3916,7 @@ void cpu::and_c()
  */
 void cpu::and_d()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _D;
-
-    check_z(_A);
+    alu_and(_D);
 }
 
 /* 0xA3 AND E : Logical AND between A and E. Result in A
@@ -2978,13 +3929,7 @@ void cpu::and_d()
  */
 void cpu::and_e()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _E;
-
-    check_z(_A);
+    alu_and(_E);
 }
 
 /* 0xA4 AND H : Logical AND between A and H. Result in A
@@ -2997,13 +3942,7 @@ void cpu::and_e()
  */
 void cpu::and_h()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _H;
-
-    check_z(_A);
+    alu_and(_H);
 }
 
 /* 0xA5 AND L : Logical AND between A and L. Result in A
@@ -3016,13 +3955,7 @@ void cpu::and_h()
  */
 void cpu::and_l()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _L;
-
-    check_z(_A);
+    alu_and(_L);
 }
 
 /* 0xA6 AND (HL) : Logical AND between A and value pointed by HL. Result in A
@@ -3035,13 +3968,7 @@ void cpu::and_l()
  */
 void cpu::and_hl()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _MMU->rb(_HL);
-
-    check_z(_A);
+    alu_and(memory.rb(_HL));
 }
 
 /* 0xA7 AND A : Logical AND between A and A. Result in A
@@ -3054,13 +3981,7 @@ void cpu::and_hl()
  */
 void cpu::and_a()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _A;
-
-    check_z(_A);
+    alu_and(_A);
 }
 
 /* 0xA8 XOR B : Logical XOR between A and B. Result in A
@@ -3073,13 +3994,7 @@ void cpu::and_a()
  */
 void cpu::xor_b()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _B;
-
-    check_z(_A);
+    alu_xor(_B);
 }
 
 /* 0xA9 XOR C : Logical XOR between A and C. Result in A
@@ -3092,13 +4007,7 @@ void cpu::xor_b()
  */
 void cpu::xor_c()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _C;
-
-    check_z(_A);
+    alu_xor(_C);
 }
 
 /* 0xAA XOR D : Logical XOR between A and D. Result in A
@@ -3111,13 +4020,7 @@ void cpu::xor_c()
  */
 void cpu::xor_d()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _D;
-
-    check_z(_A);
+    alu_xor(_D);
 }
 
 /* 0xAB XOR E : Logical XOR between A and E. Result in A
@@ -3130,13 +4033,7 @@ void cpu::xor_d()
  */
 void cpu::xor_e()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _E;
-
-    check_z(_A);
+    alu_xor(_E);
 }
 
 /* 0xAC XOR H : Logical XOR between A and H. Result in A
@@ -3149,13 +4046,7 @@ void cpu::xor_e()
  */
 void cpu::xor_h()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _H;
-
-    check_z(_A);
+    alu_xor(_H);
 }
 
 /* 0xAD XOR L : Logical XOR between A and L. Result in A
@@ -3168,13 +4059,7 @@ void cpu::xor_h()
  */
 void cpu::xor_l()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _L;
-
-    check_z(_A);
+    alu_xor(_L);
 }
 
 /* 0xAE XOR (HL) : Logical XOR between A and value pointed by HL. Result in A
@@ -3187,13 +4072,7 @@ void cpu::xor_l()
  */
 void cpu::xor_hl()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _MMU->rb(_HL);
-
-    check_z(_A);
+    alu_xor(memory.rb(_HL));
 }
 
 /* 0xAF XOR A : Logical XOR between A and A. Result in A
@@ -3206,13 +4085,7 @@ void cpu::xor_hl()
  */
 void cpu::xor_a()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _A;
-
-    check_z(_A);
+    alu_xor(_A);
 }
 
 
@@ -3226,13 +4099,7 @@ void cpu::xor_a()
  */
 void cpu::or_b()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _B;
-
-    check_z(_A);
+    alu_or(_B);
 }
 
 /* 0xB1 OR C : Logical OR between A and C. Result in A
@@ -3245,13 +4112,7 @@ void cpu::or_b()
  */
 void cpu::or_c()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _C;
-
-    check_z(_A);
+    alu_or(_C);
 }
 
 /* 0xB2 OR D : Logical OR between A and D. Result in A
@@ -3264,13 +4125,7 @@ void cpu::or_c()
  */
 void cpu::or_d()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _D;
-
-    check_z(_A);
+    alu_or(_D);
 }
 
 /* 0xB3 OR E : Logical OR between A and E. Result in A
@@ -3283,13 +4138,7 @@ void cpu::or_d()
  */
 void cpu::or_e()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _E;
-
-    check_z(_A);
+    alu_or(_E);
 }
 
 /* 0xB4 OR H : Logical OR between A and H. Result in A
@@ -3302,13 +4151,7 @@ void cpu::or_e()
  */
 void cpu::or_h()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _H;
-
-    check_z(_A);
+    alu_or(_H);
 }
 
 /* 0xB5 OR L : Logical OR between A and L. Result in A
@@ -3321,13 +4164,7 @@ void cpu::or_h()
  */
 void cpu::or_l()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _L;
-
-    check_z(_A);
+    alu_or(_L);
 }
 
 /* 0xB6 OR (HL) : Logical OR between A and value pointed by HL. Result in A
@@ -3340,13 +4177,7 @@ void cpu::or_l()
  */
 void cpu::or_hl()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _MMU->rb(_HL);
-
-    check_z(_A);
+    alu_or(memory.rb(_HL));
 }
 
 /* 0xB7 OR A : Logical OR between A and L. Result in A
@@ -3359,13 +4190,7 @@ void cpu::or_hl()
  */
 void cpu::or_a()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _A;
-
-    check_z(_A);
+    alu_or(_A);
 }
 
 /* 0xB8 CP B : Compare A with B. (Basically A - B instruction with result thrown away)
@@ -3378,10 +4203,7 @@ void cpu::or_a()
  */
 void cpu::cp_b()
 {
-    set_n();
-    check_h_sub8(_A, _B);
-    check_c_sub8(_A, _B);
-    check_z(_A - _B);
+    alu_cp(_B);
 }
 
 /* 0xB9 CP C : Compare A with C. (Basically A - C instruction with result thrown away)
@@ -3394,10 +4216,7 @@ void cpu::cp_b()
  */
 void cpu::cp_c()
 {
-    set_n();
-    check_h_sub8(_A, _C);
-    check_c_sub8(_A, _C);
-    check_z(_A - _C);
+    alu_cp(_C);
 }
 
 /* 0xBA CP D : Compare A with D. (Basically A - D instruction with result thrown away)
@@ -3410,10 +4229,7 @@ void cpu::cp_c()
  */
 void cpu::cp_d()
 {
-    set_n();
-    check_h_sub8(_A, _D);
-    check_c_sub8(_A, _D);
-    check_z(_A - _D);
+    alu_cp(_D);
 }
 
 /* 0xBB CP E : Compare A with E. (Basically A - E instruction with result thrown away)
@@ -3426,10 +4242,7 @@ void cpu::cp_d()
  */
 void cpu::cp_e()
 {
-    set_n();
-    check_h_sub8(_A, _E);
-    check_c_sub8(_A, _E);
-    check_z(_A - _E);
+    alu_cp(_E);
 }
 
 /* 0xBC CP H : Compare A with H. (Basically A - H instruction with result thrown away)
@@ -3442,10 +4255,7 @@ void cpu::cp_e()
  */
 void cpu::cp_h()
 {
-    set_n();
-    check_h_sub8(_A, _H);
-    check_c_sub8(_A, _H);
-    check_z(_A - _H);
+    alu_cp(_H);
 }
 
 /* 0xBD CP L : Compare A with L. (Basically A - L instruction with result thrown away)
@@ -3458,10 +4268,7 @@ void cpu::cp_h()
  */
 void cpu::cp_l()
 {
-    set_n();
-    check_h_sub8(_A, _L);
-    check_c_sub8(_A, _L);
-    check_z(_A - _L);
+    alu_cp(_L);
 }
 
 /* 0xBE CP (HL) : Compare A with value pointed by HL. (Basically A - value instruction with result thrown away)
@@ -3474,11 +4281,7 @@ void cpu::cp_l()
  */
 void cpu::cp_hl()
 {
-    quint8 val = _MMU->rb(_HL);
-    set_n();
-    check_h_sub8(_A, val);
-    check_c_sub8(_A, val);
-    check_z(_A - val);
+    alu_cp(memory.rb(_HL));
 }
 
 /* 0xBF CP A : Compare A with A. (Basically A - A instruction with result thrown away)
@@ -3491,10 +4294,7 @@ void cpu::cp_hl()
  */
 void cpu::cp_a()
 {
-    set_n();
-    check_h_sub8(_A, _A);
-    check_c_sub8(_A, _A);
-    check_z(_A - _A);
+    alu_cp(_A);
 }
 
 
@@ -3508,7 +4308,8 @@ void cpu::ret_nz()
 {
     if(!z_flag())
     {
-        PC = _MMU->rw(SP);
+        PC = memory.rw(SP);
+        PC -= current_opcode->length;
         SP += 2;
     }
     else
@@ -3522,8 +4323,7 @@ void cpu::ret_nz()
  */
 void cpu::pop_bc()
 {
-    _C = _MMU->rb(SP);
-    _B = _MMU->rb(SP+1);
+    _BC = memory.rw(SP);
 
     SP += 2;
 }
@@ -3565,10 +4365,10 @@ void cpu::call_nz_a16()
 {
     if(!z_flag())
     {
-        _MMU->ww(SP, PC);
+        memory.ww(SP-2, PC + current_opcode->length);
+        SP -= 2;
         PC = _a16;
         PC -= current_opcode->length;
-        SP -= 2;
     }
     else
         last_opcode_not_executed = true;
@@ -3581,8 +4381,7 @@ void cpu::call_nz_a16()
  */
 void cpu::push_bc()
 {
-    _MMU->wb(SP-1, _B);
-    _MMU->wb(SP-2, _C);
+    memory.ww(SP-2, _BC);
     SP -= 2;
 }
 
@@ -3596,15 +4395,7 @@ void cpu::push_bc()
  */
 void cpu::add_a_d8()
 {
-    quint8 val = _d8;
-    reset_n();
-
-    check_h_add8(_A, val);
-    check_c_add8(_A, val);
-
-    _A += val;
-
-    check_z(_A);
+    alu_add(_d8);
 }
 
 /* 0xC7 RST 00h : Call routine at address 00h
@@ -3614,10 +4405,10 @@ void cpu::add_a_d8()
  */
 void cpu::rst_00h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x0;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 /* 0xC8 RET Z : Return if last result was zero
@@ -3629,7 +4420,8 @@ void cpu::ret_z()
 {
     if(z_flag())
     {
-        PC = _MMU->rw(SP);
+        PC = memory.rw(SP);
+        PC -= current_opcode->length;
         SP += 2;
     }
     else
@@ -3643,7 +4435,8 @@ void cpu::ret_z()
  */
 void cpu::ret()
 {
-    PC = _MMU->rw(SP);
+    PC = memory.rw(SP);
+    PC -= current_opcode->length;
     SP += 2;
 }
 
@@ -3664,13 +4457,16 @@ void cpu::jp_z_a16()
 
 }
 /* 0xCB PREFIX CB : Extended Operations (2-bytes opcodes)
+ * The extended opcode becomes the current one, so its length and cycles are the ones accounted.
  *
  * Flags affected:
  * None
  */
 void cpu::prefix_cb()
 {
+    current_opcode = &extended_opcodes_table[fetch(PC+1)];
 
+    (this->*(current_opcode->exec))();
 }
 
 /* 0xCC CALL Z, a16 : Call routine at 16-bit location if last result was zero
@@ -3682,10 +4478,10 @@ void cpu::call_z_a16()
 {
     if(z_flag())
     {
-        _MMU->ww(SP, PC);
+        memory.ww(SP-2, PC + current_opcode->length);
+        SP -= 2;
         PC = _a16;
         PC -= current_opcode->length;
-        SP -= 2;
     }
     else
         last_opcode_not_executed = true;
@@ -3698,10 +4494,10 @@ void cpu::call_z_a16()
  */
 void cpu::call_a16()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = _a16;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 /* 0xCE ADC A, d8 : Add 8-bit immediate and carry flag to A
@@ -3714,16 +4510,7 @@ void cpu::call_a16()
  */
 void cpu::adc_a_d8()
 {
-    quint8 cf = (c_flag() ? 1 : 0);
-    quint8 val = _d8;
-    reset_n();
-
-    check_h_add8(_A, val + cf);
-    check_c_add8(_A, val + cf);
-
-    _A += (val + cf);
-
-    check_z(_A);
+    alu_adc(_d8);
 }
 
 /* 0xCF RST 08h : Call routine at address 08h
@@ -3733,10 +4520,10 @@ void cpu::adc_a_d8()
  */
 void cpu::rst_08h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x08;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 
@@ -3749,7 +4536,8 @@ void cpu::ret_nc()
 {
    if(!c_flag())
    {
-       PC = _MMU->rw(SP);
+       PC = memory.rw(SP);
+       PC -= current_opcode->length;
        SP += 2;
    }
    else
@@ -3763,8 +4551,7 @@ void cpu::ret_nc()
  */
 void cpu::pop_de()
 {
-    _E = _MMU->rb(SP);
-    _D = _MMU->rb(SP+1);
+    _DE = memory.rw(SP);
 
     SP += 2;
 }
@@ -3795,10 +4582,10 @@ void cpu::call_nc_a16()
 {
     if(!c_flag())
     {
-        _MMU->ww(SP, PC);
+        memory.ww(SP-2, PC + current_opcode->length);
+        SP -= 2;
         PC = _a16;
         PC -= current_opcode->length;
-        SP -= 2;
     }
     else
         last_opcode_not_executed = true;
@@ -3811,8 +4598,7 @@ void cpu::call_nc_a16()
  */
 void cpu::push_de()
 {
-    _MMU->wb(SP-1, _D);
-    _MMU->wb(SP-2, _E);
+    memory.ww(SP-2, _DE);
     SP -= 2;
 }
 
@@ -3826,15 +4612,7 @@ void cpu::push_de()
  */
 void cpu::sub_d8()
 {
-    quint8 val = _d8;
-
-    set_n();
-    check_h_sub8(_A, val);
-    check_c_sub8(_A, val);
-
-    _A -= val;
-
-    check_z(_A);
+    alu_sub(_d8);
 }
 
 /* 0xD7 RST 10h : Call routine at address 10h
@@ -3844,10 +4622,10 @@ void cpu::sub_d8()
  */
 void cpu::rst_10h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x10;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 /* 0xD8 RET C : Return if last result caused carry
@@ -3859,7 +4637,8 @@ void cpu::ret_c()
 {
     if(c_flag())
     {
-        PC = _MMU->rw(SP);
+        PC = memory.rw(SP);
+        PC -= current_opcode->length;
         SP += 2;
     }
     else
@@ -3874,7 +4653,8 @@ void cpu::ret_c()
 void cpu::reti()
 {
     IME = true;
-    PC = _MMU->rw(SP);
+    PC = memory.rw(SP);
+    PC -= current_opcode->length;
     SP += 2;
 }
 
@@ -3904,10 +4684,10 @@ void cpu::call_c_a16()
 {
     if(c_flag())
     {
-        _MMU->ww(SP, PC);
+        memory.ww(SP-2, PC + current_opcode->length);
+        SP -= 2;
         PC = _a16;
         PC -= current_opcode->length;
-        SP -= 2;
     }
     else
         last_opcode_not_executed = true;
@@ -3923,16 +4703,7 @@ void cpu::call_c_a16()
  */
 void cpu::sbc_a_d8()
 {
-    quint8 val = _d8;
-    quint8 cf = (c_flag() ? 1 : 0);
-
-    set_n();
-    check_h_sub8(_A, val + cf);
-    check_c_sub8(_A, val + cf);
-
-    _A -= (val + cf);
-
-    check_z(_A);
+    alu_sbc(_d8);
 }
 
 /* 0xDF RST 18h : Call routine at address 18h
@@ -3942,10 +4713,10 @@ void cpu::sbc_a_d8()
  */
 void cpu::rst_18h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x18;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 
@@ -3957,7 +4728,7 @@ void cpu::rst_18h()
  */
 void cpu::ldh_a8_a()
 {
-    _MMU->wb(0xFF00 + _a8, _A);
+    memory.wb(0xFF00 + _a8, _A);
 }
 
 /* 0xE1 POP HL : Pop 16-bit value from stack into HL
@@ -3967,8 +4738,7 @@ void cpu::ldh_a8_a()
  */
 void cpu::pop_hl()
 {
-    _L = _MMU->rb(SP);
-    _H = _MMU->rb(SP+1);
+    _HL = memory.rw(SP);
 
     SP += 2;
 }
@@ -3980,7 +4750,7 @@ void cpu::pop_hl()
  */
 void cpu::ld_c_a_()
 {
-    _MMU->wb(0xFF00 + _C, _A);
+    memory.wb(0xFF00 + _C, _A);
 }
 
 /* 0xE5 PUSH HL : Push HL into stack
@@ -3990,8 +4760,7 @@ void cpu::ld_c_a_()
  */
 void cpu::push_hl()
 {
-    _MMU->wb(SP-1, _H);
-    _MMU->wb(SP-2, _L);
+    memory.ww(SP-2, _HL);
     SP -= 2;
 }
 
@@ -4005,13 +4774,7 @@ void cpu::push_hl()
  */
 void cpu::and_d8()
 {
-    reset_n();
-    set_h();
-    reset_c();
-
-    _A &= _d8;
-
-    check_z(_A);
+    alu_and(_d8);
 }
 
 /* 0xE7 RST 20h : Call routine at address 20h
@@ -4021,10 +4784,10 @@ void cpu::and_d8()
  */
 void cpu::rst_20h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x20;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 /* 0xE8 ADD SP, r8 : Add signed 8-bit immediate to SP.
@@ -4054,7 +4817,7 @@ void cpu::add_sp_r8()
  */
 void cpu::jp_hl()
 {
-    PC = _MMU->rw(_HL);
+    PC = memory.rw(_HL);
     PC -= current_opcode->length;
 }
 
@@ -4065,7 +4828,7 @@ void cpu::jp_hl()
  */
 void cpu::ld_a16_a()
 {
-    _MMU->wb(_a16, _A);
+    memory.wb(_a16, _A);
 }
 
 /* 0xEE XOR d8 : Logical XOR between A and 8-bit immediate. Result in A
@@ -4078,13 +4841,7 @@ void cpu::ld_a16_a()
  */
 void cpu::xor_d8()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A ^= _d8;
-
-    check_z(_A);
+    alu_xor(_d8);
 }
 
 /* 0xEF RST 28h : Call routine at address 28h
@@ -4094,10 +4851,10 @@ void cpu::xor_d8()
  */
 void cpu::rst_28h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x28;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 
@@ -4108,7 +4865,7 @@ void cpu::rst_28h()
  */
 void cpu::ldh_a_a8()
 {
-    _A = _MMU->rb(0xFF00 + _a8);
+    _A = memory.rb(0xFF00 + _a8);
 }
 
 /* 0xF1 POP AF : Pop 16-bit value from stack into AF
@@ -4118,8 +4875,10 @@ void cpu::ldh_a_a8()
  */
 void cpu::pop_af()
 {
-    F = _MMU->rb(SP);
-    _A = _MMU->rb(SP+1);
+    _AF = memory.rw(SP);
+#ifdef GB_LAZY_FLAGS
+    flags_op = FLAGS_NONE;
+#endif
 
     SP += 2;
 }
@@ -4131,7 +4890,7 @@ void cpu::pop_af()
  */
 void cpu::ld_a_c_()
 {
-    _A = _MMU->rb(0xFF00 + _C);
+    _A = memory.rb(0xFF00 + _C);
 }
 
 /* 0xF3 DI : Disable interrupts
@@ -4151,8 +4910,8 @@ void cpu::di()
  */
 void cpu::push_af()
 {
-    _MMU->wb(SP-1, _A);
-    _MMU->wb(SP-2, F);
+    sync_flags();
+    memory.ww(SP-2, _AF);
     SP -= 2;
 }
 
@@ -4166,13 +4925,7 @@ void cpu::push_af()
  */
 void cpu::or_d8()
 {
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A |= _d8;
-
-    check_z(_A);
+    alu_or(_d8);
 }
 
 /* 0xF7 RST 30h : Call routine at address 30h
@@ -4182,10 +4935,10 @@ void cpu::or_d8()
  */
 void cpu::rst_30h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x30;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 /* 0xF8 LDHL SP, r8 : Put SP + 8-bit signed value into HL
@@ -4205,7 +4958,7 @@ void cpu::ldhl_sp_r8()
     check_h_add16(SP, val);
     check_c_add16(SP, val);
 
-    write_on_register(REGISTER_HL, SP + val);
+    _HL = SP + val;
 }
 
 /* 0xF9 LD SP, HL : Copy HL to SP
@@ -4225,7 +4978,7 @@ void cpu::ld_sp_hl()
  */
 void cpu::ld_a_a16()
 {
-    _A = _MMU->rb(_a16);
+    _A = memory.rb(_a16);
 }
 
 /* 0xFB EI : Enable interrupts
@@ -4248,12 +5001,7 @@ void cpu::ei()
  */
 void cpu::cp_d8()
 {
-    quint8 val = _d8;
-
-    set_n();
-    check_h_sub8(_A, val);
-    check_c_sub8(_A, val);
-    check_z(_A - val);
+    alu_cp(_d8);
 }
 
 /* 0xFF RST 38h : Call routine at address 38h
@@ -4263,2656 +5011,188 @@ void cpu::cp_d8()
  */
 void cpu::rst_38h()
 {
-    _MMU->ww(SP, PC);
+    memory.ww(SP-2, PC + current_opcode->length);
+    SP -= 2;
     PC = 0x38;
     PC -= current_opcode->length;
-    SP -= 2;
 }
 
 
 
 //2-bytes opcodes
 
-/* 0xCB00 RLC B : Rotate B left. Old bit 7 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
+/* Register operand of a 2-bytes opcode, as encoded in its 3 lower bits :
+ * 0 B, 1 C, 2 D, 3 E, 4 H, 5 L, 6 value pointed by HL, 7 A
  */
-void cpu::rlc_b()
+template<quint8 reg>
+quint8 cpu::cb_read()
 {
-    reset_n();
-    reset_h();
-
-    check_c_rl(_B);
-
-    _B = ( (_B & 0x80) ? (_B << 1) + 1 : (_B << 1) );
+    switch(reg)
+    {
+    case 0: return _B;
+    case 1: return _C;
+    case 2: return _D;
+    case 3: return _E;
+    case 4: return _H;
+    case 5: return _L;
+    case 6: return memory.rb(_HL);
+    default: return _A;
+    }
+}
 
-    check_z(_B);
+template<quint8 reg>
+void cpu::cb_write(quint8 val)
+{
+    switch(reg)
+    {
+    case 0: _B = val; break;
+    case 1: _C = val; break;
+    case 2: _D = val; break;
+    case 3: _E = val; break;
+    case 4: _H = val; break;
+    case 5: _L = val; break;
+    case 6: memory.wb(_HL, val); break;
+    default: _A = val; break;
+    }
 }
 
-/* 0xCB01 RLC C : Rotate C left. Old bit 7 to Carry flag.
+/* 0xCB00 - 0xCB3F RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL : Rotate or shift a register
+ *
+ * RLC : Rotate left. Old bit 7 to Carry flag.
+ * RRC : Rotate right. Old bit 0 to Carry flag.
+ * RL : Rotate left through Carry flag.
+ * RR : Rotate right through Carry flag.
+ * SLA : Shift left into Carry. LSB set to 0.
+ * SRA : Shift right into Carry. MSB does not change.
+ * SWAP : Swap upper & lower nibbles.
+ * SRL : Shift right into Carry. MSB set to 0.
  *
  * Flags affected:
  * Z - Set if result is zero.
  * N - Reset.
  * H - Reset.
- * C - Contains old bit 7 data.
+ * C - Contains old bit 7 data for left rotates and shifts, old bit 0 data for right ones. Reset for SWAP.
  */
-void cpu::rlc_c()
+template<quint8 operation, quint8 reg>
+void cpu::cb_shift()
 {
-   reset_n();
-   reset_h();
+    quint8 val = cb_read<reg>();
+    bool carry = false;
 
-   check_c_rl(_C);
+    reset_n();
+    reset_h();
 
-   _C = ( (_C & 0x80) ? (_C << 1) + 1 : (_C << 1) );
+    switch(operation)
+    {
+    case CB_RLC:
+        carry = val & 0x80;
+        val = (val << 1) | (val >> 7);
+        break;
 
-   check_z(_C);
-}
+    case CB_RRC:
+        carry = val & 0x01;
+        val = (val >> 1) | (val << 7);
+        break;
 
-/* 0xCB02 RLC D : Rotate D left. Old bit 7 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rlc_d()
-{
-   reset_n();
-   reset_h();
+    case CB_RL:
+        carry = val & 0x80;
+        val = (val << 1) | (c_flag() ? 0x01 : 0);
+        break;
 
-   check_c_rl(_D);
+    case CB_RR:
+        carry = val & 0x01;
+        val = (val >> 1) | (c_flag() ? 0x80 : 0);
+        break;
 
-   _D = ( (_D & 0x80) ? (_D << 1) + 1 : (_D << 1) );
+    case CB_SLA:
+        carry = val & 0x80;
+        val <<= 1;
+        break;
 
-   check_z(_D);
-}
+    case CB_SRA:
+        carry = val & 0x01;
+        val = (val >> 1) | (val & 0x80);
+        break;
 
-/* 0xCB03 RLC E : Rotate E left. Old bit 7 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rlc_e()
-{
-   reset_n();
-   reset_h();
+    case CB_SWAP:
+        val = (val >> 4) | (val << 4);
+        break;
+
+    case CB_SRL:
+        carry = val & 0x01;
+        val >>= 1;
+        break;
+    }
 
-   check_c_rl(_E);
+    if(carry) set_c();
+    else reset_c();
 
-   _E = ( (_E & 0x80) ? (_E << 1) + 1 : (_E << 1) );
+    cb_write<reg>(val);
 
-   check_z(_E);
+    check_z(val);
 }
 
-/* 0xCB04 RLC H : Rotate H left. Old bit 7 to Carry flag.
+/* 0xCB40 - 0xCB7F BIT b, r : Test bit b of a register
  *
  * Flags affected:
- * Z - Set if result is zero.
+ * Z - Set if bit is 0.
  * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
+ * H - Set.
+ * C - Not affected.
  */
-void cpu::rlc_h()
+template<quint8 bit, quint8 reg>
+void cpu::cb_bit()
 {
-   reset_n();
-   reset_h();
-
-   check_c_rl(_H);
-
-   _H = ( (_H & 0x80) ? (_H << 1) + 1 : (_H << 1) );
+    reset_n();
+    set_h();
 
-   check_z(_H);
+    check_z(cb_read<reg>() & (1 << bit));
 }
 
-/* 0xCB05 RLC L : Rotate L left. Old bit 7 to Carry flag.
+/* 0xCB80 - 0xCBBF RES b, r : Reset bit b of a register
  *
  * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
+ * None
  */
-void cpu::rlc_l()
+template<quint8 bit, quint8 reg>
+void cpu::cb_res()
 {
-   reset_n();
-   reset_h();
-
-   check_c_rl(_L);
-
-   _L = ( (_L & 0x80) ? (_L << 1) + 1 : (_L << 1) );
-
-   check_z(_L);
+    cb_write<reg>(cb_read<reg>() & ~(1 << bit));
 }
 
-/* 0xCB06 RLC (HL) : Rotate value pointed by HL left. Old bit 7 to Carry flag.
+/* 0xCBC0 - 0xCBFF SET b, r : Set bit b of a register
  *
  * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
+ * None
  */
-void cpu::rlc_hl()
+template<quint8 bit, quint8 reg>
+void cpu::cb_set()
 {
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-    reset_h();
-
-    check_c_rl(val);
-
-    val = ( (val & 0x80) ? (val << 1) + 1 : (val << 1) );
-    _MMU->wb(_HL, val);
-
-    check_z(val);
+    cb_write<reg>(cb_read<reg>() | (1 << bit));
 }
 
-/* 0xCB07 RLC A : Rotate A left. Old bit 7 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
+/* Superinstruction : run the opcodes first and second of opcodes_table with a single dispatch.
+ * The handlers are called directly, the immediate of first being in the low bytes of operand and
+ * the one of second above it. Each handler sees its own table entry and PC as if it was run alone,
+ * since jumps are relative to their own opcode.
  */
-void cpu::rlc_a()
+template<quint8 first, quint8 second>
+void cpu::fused()
 {
-   reset_n();
-   reset_h();
+    const opcode* pair = current_opcode;
+    quint32 operands = operand;
 
-   check_c_rl(_A);
+    current_opcode = &opcodes_table[first];
+    operand = operands;
+    (this->*(opcodes_table[first].exec))();
 
-   _A = ( (_A & 0x80) ? (_A << 1) + 1 : (_A << 1) );
+    PC += opcodes_table[first].length;
 
-   check_z(_A);
-}
-
-/* 0xCB08 RRC B : Rotate B right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_b()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_B);
+    current_opcode = &opcodes_table[second];
+    operand = operands >> ((opcodes_table[first].length - 1) * 8);
+    (this->*(opcodes_table[second].exec))();
 
-    _B = ( (_B & 0x1) ? (_B >> 1) + 0x80 : (_B >> 1) );
+    PC -= opcodes_table[first].length;
 
-    check_z(_B);
+    current_opcode = pair;
 }
-
-/* 0xCB09 RRC C : Rotate C right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_c()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_C);
-
-    _C = ( (_C & 0x1) ? (_C >> 1) + 0x80 : (_C >> 1) );
-
-    check_z(_C);
-}
-
-/* 0xCB0A RRC D : Rotate D right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_d()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_D);
-
-    _D = ( (_D & 0x1) ? (_D >> 1) + 0x80 : (_D >> 1) );
-
-    check_z(_D);
-}
-
-/* 0xCB0B RRC E : Rotate E right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_e()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_E);
-
-    _E = ( (_E & 0x1) ? (_E >> 1) + 0x80 : (_E >> 1) );
-
-    check_z(_E);
-}
-
-/* 0xCB0C RRC H : Rotate H right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_h()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_H);
-
-    _H = ( (_H & 0x1) ? (_H >> 1) + 0x80 : (_H >> 1) );
-
-    check_z(_H);
-}
-
-/* 0xCB0D RRC L : Rotate L right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_l()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_L);
-
-    _L = ( (_L & 0x1) ? (_L >> 1) + 0x80 : (_L >> 1) );
-
-    check_z(_L);
-}
-
-/* 0xCB0E RRC (HL) : Rotate value pointed by HL right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-    reset_h();
-    check_c_rr(val);
-
-    val = ( (val & 0x1) ? (val >> 1) + 0x80 : (val >> 1) );
-    _MMU->wb(_HL, val);
-
-    check_z(val);
-}
-
-/* 0xCB0F RRC A : Rotate A right. Old bit 0 to Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rrc_a()
-{
-    reset_n();
-    reset_h();
-    check_c_rr(_A);
-
-    _A = ( (_A & 0x1) ? (_A >> 1) + 0x80 : (_A >> 1) );
-
-    check_z(_A);
-}
-
-
-
-/* 0xCB10 RL B : Rotate B left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_b()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _B & 0x80;
-
-    _B = ( c_flag() ? (_B << 1) + 1 : (_B << 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_B);
-}
-
-/* 0xCB11 RL C : Rotate C left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_c()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _C & 0x80;
-
-    _C = ( c_flag() ? (_C << 1) + 1 : (_C << 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_C);
-}
-
-/* 0xCB12 RL D : Rotate D left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_d()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _D & 0x80;
-
-    _D = ( c_flag() ? (_D << 1) + 1 : (_D << 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_D);
-}
-
-/* 0xCB13 RL E : Rotate E left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_e()
-{
-   reset_n();
-   reset_h();
-
-   quint8 old_bit = _E & 0x80;
-
-   _E = ( c_flag() ? (_E << 1) + 1 : (_E << 1) );
-
-   if(old_bit) set_c();
-   else reset_c();
-
-   check_z(_E);
-}
-
-/* 0xCB14 RL H : Rotate H left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_h()
-{
-   reset_n();
-   reset_h();
-
-   quint8 old_bit = _H & 0x80;
-
-   _H = ( c_flag() ? (_H << 1) + 1 : (_H << 1) );
-
-   if(old_bit) set_c();
-   else reset_c();
-
-   check_z(_H);
-}
-
-/* 0xCB15 RL L : Rotate L left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_l()
-{
-   reset_n();
-   reset_h();
-
-   quint8 old_bit = _L & 0x80;
-
-   _L = ( c_flag() ? (_L << 1) + 1 : (_L << 1) );
-
-   if(old_bit) set_c();
-   else reset_c();
-
-   check_z(_L);
-}
-
-/* 0xCB16 RL (HL) : Rotate value pointed by HL left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_hl()
-{
-   reset_n();
-   reset_h();
-
-   quint8 val = _MMU->rb(_HL);
-   quint8 old_bit = val & 0x80;
-
-   val = ( c_flag() ? (val << 1) + 1 : (val << 1) );
-   _MMU->wb(_HL, val);
-
-   if(old_bit) set_c();
-   else reset_c();
-
-   check_z(val);
-}
-
-/* 0xCB17 RL A : Rotate A left through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::rl_a()
-{
-   reset_n();
-   reset_h();
-
-   quint8 old_bit = _L & 0x80;
-
-   _A = ( c_flag() ? (_A << 1) + 1 : (_A << 1) );
-
-   if(old_bit) set_c();
-   else reset_c();
-
-   check_z(_A);
-}
-
-/* 0xCB18 RR B : Rotate B right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_b()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _B & 0x1;
-
-    _B = ( c_flag() ? (_B >> 1) + 0x80 : (_B >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_B);
-}
-
-/* 0xCB19 RR C : Rotate C right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_c()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _C & 0x1;
-
-    _C = ( c_flag() ? (_C >> 1) + 0x80 : (_C >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_C);
-}
-
-/* 0xCB1A RR D : Rotate D right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_d()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _D & 0x1;
-
-    _D = ( c_flag() ? (_D >> 1) + 0x80 : (_D >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_D);
-}
-
-/* 0xCB1B RR E : Rotate E right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_e()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _E & 0x1;
-
-    _E = ( c_flag() ? (_E >> 1) + 0x80 : (_E >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_E);
-}
-
-/* 0xCB1C RR H : Rotate H right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_h()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _H & 0x1;
-
-    _H = ( c_flag() ? (_H >> 1) + 0x80 : (_H >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_H);
-}
-
-/* 0xCB1D RR L : Rotate L right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_l()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _L & 0x1;
-
-    _L = ( c_flag() ? (_L >> 1) + 0x80 : (_L >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_L);
-}
-
-/* 0xCB1E RR (HL) : Rotate value pointed by HL right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = val & 0x1;
-
-    val = ( c_flag() ? (val >> 1) + 0x80 : (val >> 1) );
-    _MMU->wb(_HL, val);
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(val);
-}
-
-/* 0xCB1F RR A : Rotate A right through Carry flag.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::rr_a()
-{
-    reset_n();
-    reset_h();
-
-    quint8 old_bit = _A & 0x1;
-
-    _A = ( c_flag() ? (_A >> 1) + 0x80 : (_A >> 1) );
-
-    if(old_bit) set_c();
-    else reset_c();
-
-    check_z(_A);
-}
-
-
-/* 0xCB20 SLA B : Shift B left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_b()
-{
-    reset_n();
-    reset_h();
-
-    if(_B & 0x80) set_c();
-    else reset_c();
-
-    _B <<= 1;
-
-    check_z(_B);
-}
-
-/* 0xCB21 SLA C : Shift C left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_c()
-{
-   reset_n();
-   reset_h();
-
-   if(_C & 0x80) set_c();
-   else reset_c();
-
-   _C <<= 1;
-
-   check_z(_C);
-}
-
-/* 0xCB22 SLA D : Shift D left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_d()
-{
-   reset_n();
-   reset_h();
-
-   if(_D & 0x80) set_c();
-   else reset_c();
-
-   _D <<= 1;
-
-   check_z(_D);
-}
-
-/* 0xCB23 SLA E : Shift E left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_e()
-{
-   reset_n();
-   reset_h();
-
-   if(_E & 0x80) set_c();
-   else reset_c();
-
-   _E <<= 1;
-
-   check_z(_E);
-}
-
-/* 0xCB24 SLA H : Shift H left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_h()
-{
-   reset_n();
-   reset_h();
-
-   if(_H & 0x80) set_c();
-   else reset_c();
-
-   _H <<= 1;
-
-   check_z(_H);
-}
-
-/* 0xCB25 SLA L : Shift L left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_l()
-{
-   reset_n();
-   reset_h();
-
-   if(_L & 0x80) set_c();
-   else reset_c();
-
-   _L <<= 1;
-
-   check_z(_L);
-}
-
-/* 0xCB26 SLA (HL) : Shift value pointed by HL left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-    reset_h();
-
-    if(val & 0x80) set_c();
-    else reset_c();
-
-    val <<= 1;
-    _MMU->wb(_HL, val);
-
-    check_z(val);
-}
-
-/* 0xCB27 SLA A : Shift A left into Carry. LSBit of n set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 7 data.
- */
-void cpu::sla_a()
-{
-   reset_n();
-   reset_h();
-
-   if(_A & 0x80) set_c();
-   else reset_c();
-
-   _A <<= 1;
-
-   check_z(_A);
-}
-
-/* 0xCB28 SRA B : Shift B right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_b()
-{
-    reset_n();
-    reset_h();
-
-    if(_B & 0x01) set_c();
-    else reset_c();
-
-    _B = (qint8)_B >> 1;
-
-    check_z(_B);
-}
-
-/* 0xCB29 SRA C : Shift C right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_c()
-{
-    reset_n();
-    reset_h();
-
-    if(_C & 0x01) set_c();
-    else reset_c();
-
-    _C = (qint8)_C >> 1;
-
-    check_z(_C);
-}
-
-/* 0xCB2A SRA D : Shift D right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_d()
-{
-    reset_n();
-    reset_h();
-
-    if(_D & 0x01) set_c();
-    else reset_c();
-
-    _D = (qint8)_D >> 1;
-
-    check_z(_D);
-}
-
-/* 0xCB2B SRA E : Shift E right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_e()
-{
-    reset_n();
-    reset_h();
-
-    if(_E & 0x01) set_c();
-    else reset_c();
-
-    _E = (qint8)_E >> 1;
-
-    check_z(_E);
-}
-
-/* 0xCB2C SRA H : Shift H right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_h()
-{
-    reset_n();
-    reset_h();
-
-    if(_H & 0x01) set_c();
-    else reset_c();
-
-    _H = (qint8)_H >> 1;
-
-    check_z(_H);
-}
-
-/* 0xCB2D SRA L : Shift L right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_l()
-{
-    reset_n();
-    reset_h();
-
-    if(_L & 0x01) set_c();
-    else reset_c();
-
-    _L = (qint8)_L >> 1;
-
-    check_z(_L);
-}
-
-/* 0xCB2E SRA (HL) : Shift value pointed by HL right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-    reset_n();
-    reset_h();
-
-    if(val & 0x01) set_c();
-    else reset_c();
-
-    val = (qint8)val >> 1;
-    _MMU->wb(_HL, val);
-
-    check_z(val);
-}
-
-/* 0xCB2F SRA A : Shift A right into Carry. MSBit doesn't change.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::sra_a()
-{
-    reset_n();
-    reset_h();
-
-    if(_A & 0x01) set_c();
-    else reset_c();
-
-    _A = (qint8)_A >> 1;
-
-    check_z(_A);
-}
-
-
-
-/* 0xCB30 SWAP B : Swap nybbles in B
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_b()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _B = ((_B & 0xF0) >> 4) + ((_B & 0xF) << 4);
-
-    check_z(_B);
-}
-
-/* 0xCB31 SWAP C : Swap nybbles in C
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_c()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _C = ((_C & 0xF0) >> 4) + ((_C & 0xF) << 4);
-
-    check_z(_C);
-}
-
-/* 0xCB32 SWAP D : Swap nybbles in D
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_d()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _D = ((_D & 0xF0) >> 4) + ((_D & 0xF) << 4);
-
-    check_z(_D);
-}
-
-/* 0xCB33 SWAP E : Swap nybbles in E
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_e()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _E = ((_E & 0xF0) >> 4) + ((_E & 0xF) << 4);
-
-    check_z(_E);
-}
-
-/* 0xCB34 SWAP H : Swap nybbles in H
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_h()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _H = ((_H & 0xF0) >> 4) + ((_H & 0xF) << 4);
-
-    check_z(_H);
-}
-
-/* 0xCB35 SWAP L : Swap nybbles in L
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_l()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _L = ((_L & 0xF0) >> 4) + ((_L & 0xF) << 4);
-
-    check_z(_L);
-}
-
-/* 0xCB36 SWAP (HL) : Swap nybbles in value pointed by HL
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-
-    reset_n();
-    reset_h();
-    reset_c();
-
-    val = ((val & 0xF0) >> 4) + ((val & 0xF) << 4);
-    _MMU->wb(_HL, val);
-
-    check_z(val);
-}
-
-/* 0xCB37 SWAP A : Swap nybbles in A
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Reset.
- */
-void cpu::swap_a()
-{
-    reset_n();
-    reset_h();
-    reset_c();
-
-    _A = ((_A & 0xF0) >> 4) + ((_A & 0xF) << 4);
-
-    check_z(_A);
-}
-
-/* 0xCB38 SRL B : Shift B right into Carry. MSBit of B set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_b()
-{
-    reset_n();
-    reset_h();
-
-    if(_B & 0x01) set_c();
-    else reset_c();
-
-    _B >>= 1;
-
-    check_z(_B);
-}
-
-/* 0xCB39 SRL C : Shift C right into Carry. MSBit of C set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_c()
-{
-    reset_n();
-    reset_h();
-
-    if(_C & 0x01) set_c();
-    else reset_c();
-
-    _C >>= 1;
-
-    check_z(_C);
-}
-
-/* 0xCB3A SRL D : Shift D right into Carry. MSBit of D set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_d()
-{
-    reset_n();
-    reset_h();
-
-    if(_D & 0x01) set_c();
-    else reset_c();
-
-    _D >>= 1;
-
-    check_z(_D);
-}
-
-/* 0XCB3B SRL E : Shift E right into Carry. MSBit of E set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_e()
-{
-    reset_n();
-    reset_h();
-
-    if(_E & 0x01) set_c();
-    else reset_c();
-
-    _E >>= 1;
-
-    check_z(_E);
-}
-
-/* 0xCB3C SRL H : Shift H right into Carry. MSBit of H set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_h()
-{
-    reset_n();
-    reset_h();
-
-    if(_H & 0x01) set_c();
-    else reset_c();
-
-    _H >>= 1;
-
-    check_z(_H);
-}
-
-/* 0xCB3D SRL L : Shift L right into Carry. MSBit of L set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_l()
-{
-    reset_n();
-    reset_h();
-
-    if(_L & 0x01) set_c();
-    else reset_c();
-
-    _L >>= 1;
-
-    check_z(_L);
-}
-
-/* 0xCB3E SRL (HL) : Shift value pointed by HL right into Carry. MSBit of value set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-    reset_n();
-    reset_h();
-
-    if(val & 0x01) set_c();
-    else reset_c();
-
-    val >>= 1;
-    _MMU->wb(_HL, val);
-
-    check_z(val);
-}
-
-/* 0xCB3F SRL A : Shift A right into Carry. MSBit of A set to 0.
- *
- * Flags affected:
- * Z - Set if result is zero.
- * N - Reset.
- * H - Reset.
- * C - Contains old bit 0 data.
- */
-void cpu::srl_a()
-{
-    reset_n();
-    reset_h();
-
-    if(_A & 0x01) set_c();
-    else reset_c();
-
-    _A >>= 1;
-
-    check_z(_A);
-}
-
-
-
-/* 0xCB40 BIT 0, B : Test bit 0 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & 0x01);
-}
-
-/* 0xCB41 BIT 0, C : Test bit 0 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & 0x01);
-}
-
-/* 0xCB42 BIT 0, D : Test bit 0 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & 0x01);
-}
-
-/* 0xCB43 BIT 0, E : Test bit 0 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & 0x01);
-}
-
-/* 0xCB44 BIT 0, H : Test bit 0 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & 0x01);
-}
-
-/* 0xCB45 BIT 0, L : Test bit 0 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & 0x01);
-}
-
-/* 0xCB46 BIT 0, (HL) : Test bit 0 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & 0x01);
-}
-
-/* 0xCB47 BIT 0, A : Test bit 0 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_0_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & 0x01);
-}
-
-/* 0xCB48 BIT 1, B : Test bit 1 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 1));
-}
-
-/* 0xCB49 BIT 1, C : Test bit 1 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 1));
-}
-
-/* 0xCB4A BIT 1, D : Test bit 1 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 1));
-}
-
-/* 0xCB4B BIT 1, E : Test bit 1 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 1));
-}
-
-/* 0xCB4C BIT 1, H : Test bit 1 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 1));
-}
-
-/* 0xCB4D BIT 1, L : Test bit 1 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 1));
-}
-
-/* 0xCB4E BIT 1, (HL) : Test bit 1 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 1));
-}
-
-/* 0xCB4F BIT 1, A : Test bit 1 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_1_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 1));
-}
-
-
-
-/* 0xCB50 BIT 2, B : Test bit 2 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 2));
-}
-
-/* 0xCB51 BIT 2, C : Test bit 2 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 2));
-}
-
-/* 0xCB52 BIT 2, D : Test bit 2 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 2));
-}
-
-/* 0xCB53 BIT 2, E : Test bit 2 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 2));
-}
-
-/* 0xCB54 BIT 2, H : Test bit 2 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 2));
-}
-
-/* 0xCB55 BIT 2, L : Test bit 2 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 2));
-}
-
-/* 0xCB56 BIT 2, (HL) : Test bit 2 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 2));
-}
-
-/* 0xCB57 BIT 2, A : Test bit 2 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_2_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 2));
-}
-
-/* 0xCB58 BIT 3, B : Test bit 3 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 3));
-}
-
-/* 0xCB59 BIT 3, C : Test bit 3 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 3));
-}
-
-/* 0xCB5A BIT 3, D : Test bit 3 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 3));
-}
-
-/* 0xCB5B BIT 3, E : Test bit 3 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 3));
-}
-
-/* 0xCB5C BIT 3, H : Test bit 3 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 3));
-}
-
-/* 0xCB5D BIT 3, L : Test bit 3 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 3));
-}
-
-/* 0xCB5E BIT 3, (HL) : Test bit 3 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 3));
-}
-
-/* 0xCB5F BIT 3, A : Test bit 3 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_3_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 3));
-}
-
-
-
-/* 0xCB60 BIT 4, B : Test bit 4 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 4));
-}
-
-/* 0xCB61 BIT 4, C : Test bit 4 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 4));
-}
-
-/* 0xCB62 BIT 4, D : Test bit 4 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 4));
-}
-
-/* 0xCB63 BIT 4, E : Test bit 4 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 4));
-}
-
-/* 0xCB64 BIT 4, H : Test bit 4 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 4));
-}
-
-/* 0xCB65 BIT 4, L : Test bit 4 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 4));
-}
-
-/* 0xCB66 BIT 4, (HL) : Test bit 4 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 4));
-}
-
-/* 0xCB67 BIT 4, A : Test bit 4 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_4_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 4));
-}
-
-/* 0xCB68 BIT 5, B : Test bit 5 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 5));
-}
-
-/* 0xCB69 BIT 5, C : Test bit 5 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 5));
-}
-
-/* 0xCB6A BIT 5, D : Test bit 5 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 5));
-}
-
-/* 0xCB6B BIT 5, E : Test bit 5 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 5));
-}
-
-/* 0xCB6C BIT 5, H : Test bit 5 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 5));
-}
-
-/* 0xCB6D BIT 5, L : Test bit 5 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 5));
-}
-
-/* 0xCB6E BIT 5, (HL) : Test bit 5 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 5));
-}
-
-/* 0xCB6F BIT 5, A : Test bit 5 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_5_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 5));
-}
-
-
-
-/* 0xCB70 BIT 6, B : Test bit 6 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 6));
-}
-
-/* 0xCB71 BIT 6, C : Test bit 6 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 6));
-}
-
-/* 0xCB72 BIT 6, D : Test bit 6 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 6));
-}
-
-/* 0xCB73 BIT 6, E : Test bit 6 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 6));
-}
-
-/* 0xCB74 BIT 6, H : Test bit 6 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 6));
-}
-
-/* 0xCB75 BIT 6, L : Test bit 6 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 6));
-}
-
-/* 0xCB76 BIT 6, (HL) : Test bit 6 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 6));
-}
-
-/* 0xCB77 BIT 6, A : Test bit 6 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_6_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 6));
-}
-
-/* 0xCB78 BIT 7, B : Test bit 7 of B
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_b()
-{
-    reset_n();
-    set_h();
-
-    check_z(_B & (1 << 7));
-}
-
-/* 0xCB79 BIT 7, C : Test bit 7 of C
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_c()
-{
-    reset_n();
-    set_h();
-
-    check_z(_C & (1 << 7));
-}
-
-/* 0xCB7A BIT 7, D : Test bit 7 of D
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_d()
-{
-    reset_n();
-    set_h();
-
-    check_z(_D & (1 << 7));
-}
-
-/* 0xCB7B BIT 7, E : Test bit 7 of E
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_e()
-{
-    reset_n();
-    set_h();
-
-    check_z(_E & (1 << 7));
-}
-
-/* 0xCB7C BIT 7, H : Test bit 7 of H
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_h()
-{
-    reset_n();
-    set_h();
-
-    check_z(_H & (1 << 7));
-}
-
-/* 0xCB7D BIT 7, L : Test bit 7 of L
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_l()
-{
-    reset_n();
-    set_h();
-
-    check_z(_L & (1 << 7));
-}
-
-/* 0xCB7E BIT 7, (HL) : Test bit 7 of value pointed by HL
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_hl()
-{
-    reset_n();
-    set_h();
-
-    check_z(_MMU->rb(_HL) & (1 << 7));
-}
-
-/* 0xCB7F BIT 7, A : Test bit 7 of A
- *
- * Flags affected:
- * Z - Set if bit is 0.
- * N - Reset.
- * H - Set.
- * C - Not affected.
- */
-void cpu::bit_7_a()
-{
-    reset_n();
-    set_h();
-
-    check_z(_A & (1 << 7));
-}
-
-
-
-/* 0xCB80 RES 0, B : Reset bit 0 of B
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_b()
-{
-    _B &= 0xFE;
-}
-
-/* 0xCB81 RES 0, C : Reset bit 0 of C
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_c()
-{
-    _C &= 0xFE;
-}
-
-/* 0xCB82 RES 0, D : Reset bit 0 of D
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_d()
-{
-    _D &= 0xFE;
-}
-
-/* 0xCB83 RES 0, E : Reset bit 0 of E
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_e()
-{
-    _E &= 0xFE;
-}
-
-/* 0xCB84 RES 0, H : Reset bit 0 of H
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_h()
-{
-    _H &= 0xFE;
-}
-
-/* 0xCB85 RES 0, L : Reset bit 0 of L
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_l()
-{
-    _L &= 0xFE;
-}
-
-/* 0xCB86 RES 0, (HL) : Reset bit 0 of value pointed by HL
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-    val &= 0xFE;
-    _MMU->wb(_HL, val);
-}
-
-/* 0xCB87 RES 0, A : Reset bit 0 of A
- *
- * Flags affected:
- * None
- */
-void cpu::res_0_a()
-{
-    _A &= 0xFE;
-}
-
-/* 0xCB88 RES 1, B : Reset bit 1 of B
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_b()
-{
-    _B &= 0xFD;
-}
-
-/* 0xCB89 RES 1, C : Reset bit 1 of C
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_c()
-{
-    _C &= 0xFD;
-}
-
-/* 0xCB8A RES 1, D : Reset bit 1 of D
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_d()
-{
-    _D &= 0xFD;
-}
-
-/* 0xCB8B RES 1, E : Reset bit 1 of E
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_e()
-{
-    _E &= 0xFD;
-}
-
-/* 0xCB8C RES 1, H : Reset bit 1 of H
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_h()
-{
-    _H &= 0xFD;
-}
-
-/* 0xCB8D RES 1, L : Reset bit 1 of L
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_l()
-{
-    _L &= 0xFD;
-}
-
-/* 0xCB8E RES 1, (HL) : Reset bit 1 of value pointed by HL
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_hl()
-{
-    quint8 val = _MMU->rb(_HL);
-    val &= 0xFD;
-    _MMU->wb(_HL, val);
-}
-
-/* 0xCB8F RES 1, A : Reset bit 1 of A
- *
- * Flags affected:
- * None
- */
-void cpu::res_1_a()
-{
-    _A &= 0xFD;
-}
-
-
-
-
-/* 0xCB90 RES 2, B : Reset bit 2 of B
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_b()
-{
-    _B &= 0xFB;
-}
-
-/* 0xCB91 RES 2, C : Reset bit 2 of C
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_c()
-{
-    _C &= 0xFB;
-}
-
-/* 0xCB92 RES 2, D : Reset bit 2 of D
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_d()
-{
-    _D &= 0xFB;
-}
-
-/* 0xCB93 RES 2, E : Reset bit 2 of E
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_e()
-{
-    _E &= 0xFB;
-}
-
-/* 0xCB94 RES 2, H : Reset bit 2 of H
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_h()
-{
-    _H &= 0xFB;
-}
-
-/* 0xCB95 RES 2, L : Reset bit 2 of L
- *
- * Flags affected:
- * None
- */
-void cpu::res_2_l()
-{
-    _L &= 0xFB;
-}
-
-// 0xCB96 RES 2, (HL)
-void cpu::res_2_hl();
-// 0xCB97 RES 2, A
-void cpu::res_2_a();
-// 0xCB98 RES 3, B
-void cpu::res_3_b();
-// 0xCB99 RES 3, C
-void cpu::res_3_c();
-// 0xCB9A RES 3, D
-void cpu::res_3_d();
-// 0xCB9B RES 3, E
-void cpu::res_3_e();
-// 0xCB9C RES 3, H
-void cpu::res_3_h();
-// 0xCB9D RES 3, L
-void cpu::res_3_l();
-// 0xCB9E RES 3, (HL)
-void cpu::res_3_hl();
-// 0xCB9F RES 3, A
-void cpu::res_3_a();
@@ -1,29 +1,22 @@
 #ifndef CPU_H
 #define CPU_H
 
-#include <QMap>
-#include <QString>
+#include <Qt>
+#include <QtGlobal>
 
 #include <Utils.h>
 
+#include "mmu.h"
+
 namespace gb
 {
 
+class jit;
+
 class cpu : public utils::patterns::Singleton<cpu>
 {
     friend class utils::patterns::Singleton<cpu>;
-
-    enum REGISTERS
-    {
-        REGISTER_A = 0x0,
-        REGISTER_B = 0x1,
-        REGISTER_C = 0x2,
-        REGISTER_D = 0x3,
-        REGISTER_E = 0x4,
-        REGISTER_H = 0x5,
-        REGISTER_L = 0x6,
-        REGISTER_NUMBER = 0x7
-    };
+    friend class jit;
 
     enum DOUBLE_REGISTERS
     {
@@ -44,16 +37,58 @@ class cpu : public utils::patterns::Singleton<cpu>
         FLAG_Z      = 1<<7
     };
 
+    enum FLAGS_OPERATION
+    {
+        FLAGS_NONE  = 0x0, // F is up to date
+        FLAGS_ADD   = 0x1,
+        FLAGS_SUB   = 0x2,
+        FLAGS_AND   = 0x3,
+        FLAGS_LOGIC = 0x4, // OR, XOR
+        FLAGS_INC   = 0x5,
+        FLAGS_DEC   = 0x6
+    };
+
+    enum INTERRUPTS
+    {
+        INTERRUPT_FLAG      = 0xFF0F,   // IF : requested interrupts
+        INTERRUPT_ENABLE    = 0xFFFF,   // IE : enabled interrupts
+        INTERRUPT_MASK      = 0x1F      // vblank, lcd stat, timer, serial, joypad
+    };
+
+    enum POLLING_LOOP
+    {
+        POLLING_LOOP_MAX_SIZE   = 64    // bytes between a backward jump and its target for it to be checked as a loop
+    };
+
+    enum FUSED_OPCODES
+    {
+        FUSED_OPCODES_COUNT = 4
+    };
+
+    enum BLOCK_CACHE
+    {
+        BLOCK_CACHE_SIZE    = 1024, // number of blocks, indexed by the low bits of their address
+        BLOCK_MAX_OPCODES   = 32
+    };
+
 
 
     cpu();
-    ~cpu();
+
+public:
 
     bool interpret_opcode();
+    quint8 step_instruction();
+    quint32 run_for(quint32 cycles);
+    quint32 run_threaded(quint32 cycles);
+    quint32 run_block(quint32 cycles);
 
     quint16 get_pc();
+    quint8 get_f();
+    const char* get_mnemonic(quint16 address);
 
     void write_on_register(DOUBLE_REGISTERS reg, quint16 word);
+    void fast_boot(mmu::MODEL model);
 
 
 
@@ -64,32 +99,136 @@ private:
     class opcode
     {
     public:
-        opcode(QString mnemonic, quint8 length, quint8 cycles, opcode_func exec, quint8 not_exec_cycles = 0);
+        constexpr opcode(quint8 length, quint8 cycles, opcode_func exec, quint8 not_exec_cycles = 0)
+            : exec(exec), length(length), cycles(cycles), not_exec_cycles(not_exec_cycles) {}
 
-        QString mnemonic;
+        //all the dispatch needs, packed : the mnemonics are in opcodes_mnemonics
+        opcode_func exec; // pointer to the function which will execute the opcode
         quint8 length;
         quint8 cycles;
         quint8 not_exec_cycles;
-        opcode_func exec; // pointer to the function which will execute the opcode
     };
 
-    quint8                      R[REGISTER_NUMBER]                      ; //A, B, C, D, E, H, L
-    quint8                      F                                       ; //flag register
+    //pre-decoded opcode of a cached block
+    struct decoded_opcode
+    {
+        const opcode* op;       // entry of opcodes_table, of extended_opcodes_table for 0xCB opcodes, or of fused_opcodes_table
+        quint32 operand;        // immediate value following the opcode (both immediates of a fused pair)
+        quint8 code;            // first byte of the opcode (0xCB for extended opcodes, the first opcode of a fused pair)
+    };
+
+    //superinstruction : a pair of opcodes the block decoder runs with a single dispatch
+    struct fused_opcode
+    {
+        quint8 first;
+        quint8 second;
+        const char* mnemonic;
+        opcode op;
+    };
+
+    //straight-line code, from its entry address to the first jump (or page end)
+    struct block
+    {
+        quint16 address;
+        quint8 count;
+        quint16 cycles;             // if the last opcode is executed
+        quint16 not_exec_cycles;    // if the last opcode is a conditional one that is not executed
+        quint32 writes;             // mmu::page_writes() of the page when decoded
+        decoded_opcode opcodes[BLOCK_MAX_OPCODES];
+    };
+
+    //state of the cpu at the head of a loop, to find polling loops (see skip_polling_loop())
+    struct loop_state
+    {
+        quint16 address;
+        quint16 af;
+        quint16 bc;
+        quint16 de;
+        quint16 hl;
+        quint16 sp;
+        bool ime;
+        quint32 writes;             // mmu::writes_count()
+        quint32 handler_reads;      // mmu::handler_reads_count()
+        quint32 elapsed;            // cycles elapsed in run_for()
+    };
+
+    /* Register pair, read and written either as a native 16-bit word or as its two 8-bit halves.
+     * The halves are laid out according to the host byte order, so that "high" is always the first
+     * register of the pair (A, B, D, H) and "low" the second one (F, C, E, L).
+     */
+    union register_pair
+    {
+        quint16 word;
+
+        struct
+        {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            quint8 low;
+            quint8 high;
+#elif Q_BYTE_ORDER == Q_BIG_ENDIAN
+            quint8 high;
+            quint8 low;
+#else
+#error "cpu: unsupported host byte order"
+#endif
+        } bytes;
+    };
+
+    static_assert(sizeof(register_pair) == sizeof(quint16), "cpu: register pairs must be exactly 16 bits wide");
+
+    register_pair               AF                                      ; //A, F (flag register)
+    register_pair               BC                                      ; //B, C
+    register_pair               DE                                      ; //D, E
+    register_pair               HL                                      ; //H, L
+
+    quint8                      flags_op                                ; //lazy flags : last ALU operation not yet applied to F
+    quint8                      flags_val1                              ; //lazy flags : first operand (or result for AND, OR, XOR)
+    quint8                      flags_val2                              ; //lazy flags : second operand
+    bool                        flags_carry                             ; //lazy flags : carry of the operation (kept as is by INC and DEC)
 
     quint16                     SP                                      ; //stack pointer
     quint16                     PC                                      ; //program counter
 
-    QMap<quint8, opcode*>       opcodes_table                           ; //1-byte long opcodes
-    QMap<quint8, opcode*>       extended_opcodes_table                  ; //2-bytes long opcodes
+    mmu&                        memory                                  ; //the mmu, held directly so that its fast path is inlined
+
+    static const opcode         opcodes_table[256]                      ; //1-byte long opcodes, indexed by opcode
+    static const opcode         extended_opcodes_table[256]             ; //2-bytes long opcodes, indexed by the byte following 0xCB
+    static const fused_opcode   fused_opcodes_table[FUSED_OPCODES_COUNT]; //superinstructions
+    static const char* const    opcodes_mnemonics[256]                  ; //cold data of the tables above, for the debugger and the tracer
+    static const char* const    extended_opcodes_mnemonics[256]         ;
 
-    opcode*                     current_opcode                          ;
-    quint8                      cycles_counter                          ;
+    const opcode*               current_opcode                          ;
+    quint32                     operand                                 ; //immediate value of the current opcode (_d8, _d16, _a8, _a16, _r8)
+    quint8                      cycles_counter                          ; //cycles left before interpret_opcode() fetches the next opcode
 
     bool                        STOP                                    ;
     bool                        HALT                                    ;
     bool                        IME                                     ; //interrupts
     bool                        last_opcode_not_executed                ; //for jumps
 
+#ifdef GB_BLOCK_CACHE
+    block                       blocks[BLOCK_CACHE_SIZE]                ;
+#endif
+
+    //fetch functions
+    quint8 fetch(quint16 address);
+    void fetch_operand();
+
+    //interrupts functions
+    bool interrupt_pending();
+    quint32 halted_cycles(quint32 cycles);
+
+    //polling loops functions
+    void save_loop_state(loop_state* loop, quint32 elapsed);
+    quint32 skip_polling_loop(loop_state* loop, quint32 elapsed, quint32 cycles);
+
+    //block cache functions
+    static const opcode* find_fused(quint8 first, quint8 second);
+    static bool is_fused(const opcode* op);
+    static constexpr bool complete_table(const opcode* table, const char* const* mnemonics, quint16 index);
+    bool decode_block(block* b);
+    quint32 execute_block(const block* b, const quint32* writes);
+
     //flags functions
     bool z_flag();
     void check_z(quint16 val);
@@ -116,6 +255,21 @@ private:
     void set_c();
     void reset_c();
 
+    //alu functions
+    void sync_flags();
+    void materialize_flags();
+
+    void alu_add(quint8 val);
+    void alu_adc(quint8 val);
+    void alu_sub(quint8 val);
+    void alu_sbc(quint8 val);
+    void alu_and(quint8 val);
+    void alu_xor(quint8 val);
+    void alu_or(quint8 val);
+    void alu_cp(quint8 val);
+    void alu_inc(quint8& reg);
+    void alu_dec(quint8& reg);
+
     //opcodes functions
 
     void not_impl();
@@ -393,176 +547,29 @@ private:
     void cp_d8();                                       // 0xFE CP d8
     void rst_38h();                                     // 0xFF RST 38h
 
-    //2-bytes opcodes
-    void rlc_b();                                       // 0xCB00 RLC B
-    void rlc_c();                                       // 0xCB01 RLC C
-    void rlc_d();                                       // 0xCB02 RLC D
-    void rlc_e();                                       // 0xCB03 RLC E
-    void rlc_h();                                       // 0xCB04 RLC H
-    void rlc_l();                                       // 0xCB05 RLC L
-    void rlc_hl();                                      // 0xCB06 RLC (HL)
-    void rlc_a();                                       // 0xCB07 RLC A
-    void rrc_b();                                       // 0xCB08 RRC B
-    void rrc_c();                                       // 0xCB09 RRC C
-    void rrc_d();                                       // 0xCB0A RRC D
-    void rrc_e();                                       // 0xCB0B RRC E
-    void rrc_h();                                       // 0xCB0C RRC H
-    void rrc_l();                                       // 0xCB0D RRC L
-    void rrc_hl();                                      // 0xCB0E RRC (HL)
-    void rrc_a();                                       // 0xCB0F RRC A
-
-    void rl_b();                                        // 0xCB10 RL B
-    void rl_c();                                        // 0xCB11 RL C
-    void rl_d();                                        // 0xCB12 RL D
-    void rl_e();                                        // 0xCB13 RL E
-    void rl_h();                                        // 0xCB14 RL H
-    void rl_l();                                        // 0xCB15 RL L
-    void rl_hl();                                       // 0xCB16 RL (HL)
-    void rl_a();                                        // 0xCB17 RL A
-    void rr_b();                                        // 0xCB18 RR B
-    void rr_c();                                        // 0xCB19 RR C
-    void rr_d();                                        // 0xCB1A RR D
-    void rr_e();                                        // 0xCB1B RR E
-    void rr_h();                                        // 0xCB1C RR H
-    void rr_l();                                        // 0xCB1D RR L
-    void rr_hl();                                       // 0xCB1E RR (HL)
-    void rr_a();                                        // 0xCB1F RR A
-
-    void sla_b();                                       // 0xCB20 SLA B
-    void sla_c();                                       // 0xCB21 SLA C
-    void sla_d();                                       // 0xCB22 SLA D
-    void sla_e();                                       // 0xCB23 SLA E
-    void sla_h();                                       // 0xCB24 SLA H
-    void sla_l();                                       // 0xCB25 SLA L
-    void sla_hl();                                      // 0xCB26 SLA (HL)
-    void sla_a();                                       // 0xCB27 SLA A
-    void sra_b();                                       // 0xCB28 SRA B
-    void sra_c();                                       // 0xCB29 SRA C
-    void sra_d();                                       // 0xCB2A SRA D
-    void sra_e();                                       // 0xCB2B SRA E
-    void sra_h();                                       // 0xCB2C SRA H
-    void sra_l();                                       // 0xCB2D SRA L
-    void sra_hl();                                      // 0xCB2E SRA (HL)
-    void sra_a();                                       // 0xCB2F SRA A
-
-    void swap_b();                                      // 0xCB30 SWAP B
-    void swap_c();                                      // 0xCB31 SWAP C
-    void swap_d();                                      // 0xCB32 SWAP D
-    void swap_e();                                      // 0xCB33 SWAP E
-    void swap_h();                                      // 0xCB34 SWAP H
-    void swap_l();                                      // 0xCB35 SWAP L
-    void swap_hl();                                     // 0xCB36 SWAP (HL)
-    void swap_a();                                      // 0xCB37 SWAP A
-    void srl_b();                                       // 0xCB38 SRL B
-    void srl_c();                                       // 0xCB39 SRL C
-    void srl_d();                                       // 0xCB3A SRL D
-    void srl_e();                                       // 0XCB3B SRL E
-    void srl_h();                                       // 0xCB3C SRL H
-    void srl_l();                                       // 0xCB3D SRL L
-    void srl_hl();                                      // 0xCB3E SRL (HL)
-    void srl_a();                                       // 0xCB3F SRL A
-
-    void bit_0_b();                                     // 0xCB40 BIT 0, B
-    void bit_0_c();                                     // 0xCB41 BIT 0, C
-    void bit_0_d();                                     // 0xCB42 BIT 0, D
-    void bit_0_e();                                     // 0xCB43 BIT 0, E
-    void bit_0_h();                                     // 0xCB44 BIT 0, H
-    void bit_0_l();                                     // 0xCB45 BIT 0, L
-    void bit_0_hl();                                    // 0xCB46 BIT 0, (HL)
-    void bit_0_a();                                     // 0xCB47 BIT 0, A
-    void bit_1_b();                                     // 0xCB48 BIT 1, B
-    void bit_1_c();                                     // 0xCB49 BIT 1, C
-    void bit_1_d();                                     // 0xCB4A BIT 1, D
-    void bit_1_e();                                     // 0xCB4B BIT 1, E
-    void bit_1_h();                                     // 0xCB4C BIT 1, H
-    void bit_1_l();                                     // 0xCB4D BIT 1, L
-    void bit_1_hl();                                    // 0xCB4E BIT 1, (HL)
-    void bit_1_a();                                     // 0xCB4F BIT 1, A
-
-    void bit_2_b();                                     // 0xCB50 BIT 2, B
-    void bit_2_c();                                     // 0xCB51 BIT 2, C
-    void bit_2_d();                                     // 0xCB52 BIT 2, D
-    void bit_2_e();                                     // 0xCB53 BIT 2, E
-    void bit_2_h();                                     // 0xCB54 BIT 2, H
-    void bit_2_l();                                     // 0xCB55 BIT 2, L
-    void bit_2_hl();                                    // 0xCB56 BIT 2, (HL)
-    void bit_2_a();                                     // 0xCB57 BIT 2, A
-    void bit_3_b();                                     // 0xCB58 BIT 3, B
-    void bit_3_c();                                     // 0xCB59 BIT 3, C
-    void bit_3_d();                                     // 0xCB5A BIT 3, D
-    void bit_3_e();                                     // 0xCB5B BIT 3, E
-    void bit_3_h();                                     // 0xCB5C BIT 3, H
-    void bit_3_l();                                     // 0xCB5D BIT 3, L
-    void bit_3_hl();                                    // 0xCB5E BIT 3, (HL)
-    void bit_3_a();                                     // 0xCB5F BIT 3, A
-
-    void bit_4_b();                                     // 0xCB60 BIT 4, B
-    void bit_4_c();                                     // 0xCB61 BIT 4, C
-    void bit_4_d();                                     // 0xCB62 BIT 4, D
-    void bit_4_e();                                     // 0xCB63 BIT 4, E
-    void bit_4_h();                                     // 0xCB64 BIT 4, H
-    void bit_4_l();                                     // 0xCB65 BIT 4, L
-    void bit_4_hl();                                    // 0xCB66 BIT 4, (HL)
-    void bit_4_a();                                     // 0xCB67 BIT 4, A
-    void bit_5_b();                                     // 0xCB68 BIT 5, B
-    void bit_5_c();                                     // 0xCB69 BIT 5, C
-    void bit_5_d();                                     // 0xCB6A BIT 5, D
-    void bit_5_e();                                     // 0xCB6B BIT 5, E
-    void bit_5_h();                                     // 0xCB6C BIT 5, H
-    void bit_5_l();                                     // 0xCB6D BIT 5, L
-    void bit_5_hl();                                    // 0xCB6E BIT 5, (HL)
-    void bit_5_a();                                     // 0xCB6F BIT 5, A
-
-    void bit_6_b();                                     // 0xCB70 BIT 6, B
-    void bit_6_c();                                     // 0xCB71 BIT 6, C
-    void bit_6_d();                                     // 0xCB72 BIT 6, D
-    void bit_6_e();                                     // 0xCB73 BIT 6, E
-    void bit_6_h();                                     // 0xCB74 BIT 6, H
-    void bit_6_l();                                     // 0xCB75 BIT 6, L
-    void bit_6_hl();                                    // 0xCB76 BIT 6, (HL)
-    void bit_6_a();                                     // 0xCB77 BIT 6, A
-    void bit_7_b();                                     // 0xCB78 BIT 7, B
-    void bit_7_c();                                     // 0xCB79 BIT 7, C
-    void bit_7_d();                                     // 0xCB7A BIT 7, D
-    void bit_7_e();                                     // 0xCB7B BIT 7, E
-    void bit_7_h();                                     // 0xCB7C BIT 7, H
-    void bit_7_l();                                     // 0xCB7D BIT 7, L
-    void bit_7_hl();                                    // 0xCB7E BIT 7, (HL)
-    void bit_7_a();                                     // 0xCB7F BIT 7, A
-
-    void res_0_b();                                     // 0xCB80 RES 0, B
-    void res_0_c();                                     // 0xCB81 RES 0, C
-    void res_0_d();                                     // 0xCB82 RES 0, D
-    void res_0_e();                                     // 0xCB83 RES 0, E
-    void res_0_h();                                     // 0xCB84 RES 0, H
-    void res_0_l();                                     // 0xCB85 RES 0, L
-    void res_0_hl();                                    // 0xCB86 RES 0, (HL)
-    void res_0_a();                                     // 0xCB87 RES 0, A
-    void res_1_b();                                     // 0xCB88 RES 1, B
-    void res_1_c();                                     // 0xCB89 RES 1, C
-    void res_1_d();                                     // 0xCB8A RES 1, D
-    void res_1_e();                                     // 0xCB8B RES 1, E
-    void res_1_h();                                     // 0xCB8C RES 1, H
-    void res_1_l();                                     // 0xCB8D RES 1, L
-    void res_1_hl();                                    // 0xCB8E RES 1, (HL)
-    void res_1_a();                                     // 0xCB8F RES 1, A
-
-    void res_2_b();                                     // 0xCB90 RES 2, B
-    void res_2_c();                                     // 0xCB91 RES 2, C
-    void res_2_d();                                     // 0xCB92 RES 2, D
-    void res_2_e();                                     // 0xCB93 RES 2, E
-    void res_2_h();                                     // 0xCB94 RES 2, H
-    void res_2_l();                                     // 0xCB95 RES 2, L
-    void res_2_hl();                                    // 0xCB96 RES 2, (HL)
-    void res_2_a();                                     // 0xCB97 RES 2, A
-    void res_3_b();                                     // 0xCB98 RES 3, B
-    void res_3_c();                                     // 0xCB99 RES 3, C
-    void res_3_d();                                     // 0xCB9A RES 3, D
-    void res_3_e();                                     // 0xCB9B RES 3, E
-    void res_3_h();                                     // 0xCB9C RES 3, H
-    void res_3_l();                                     // 0xCB9D RES 3, L
-    void res_3_hl();                                    // 0xCB9E RES 3, (HL)
-    void res_3_a();                                     // 0xCB9F RES 3, A
+    //2-bytes opcodes (0xCB prefix), generated from the templates below
+    enum CB_OPERATIONS
+    {
+        CB_RLC      = 0x0,
+        CB_RRC      = 0x1,
+        CB_RL       = 0x2,
+        CB_RR       = 0x3,
+        CB_SLA      = 0x4,
+        CB_SRA      = 0x5,
+        CB_SWAP     = 0x6,
+        CB_SRL      = 0x7
+    };
+
+    template<quint8 reg> quint8 cb_read();
+    template<quint8 reg> void cb_write(quint8 val);
+
+    template<quint8 operation, quint8 reg> void cb_shift();  // 0xCB00 - 0xCB3F RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL
+    template<quint8 bit, quint8 reg> void cb_bit();           // 0xCB40 - 0xCB7F BIT b, r
+    template<quint8 bit, quint8 reg> void cb_res();           // 0xCB80 - 0xCBBF RES b, r
+    template<quint8 bit, quint8 reg> void cb_set();           // 0xCBC0 - 0xCBFF SET b, r
+
+    //superinstructions, generated from the template below
+    template<quint8 first, quint8 second> void fused();
 };
 
 }
@@ -0,0 +1,478 @@
+#include "jit.h"
+#include "mmu.h"
+
+#ifdef GB_JIT
+
+#if !defined(__x86_64__) && !defined(_M_X64)
+#error "GB_JIT needs an x86-64 host"
+#endif
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace gb;
+
+jit::jit()
+{
+    for(quint16 i = 0 ; i < JIT_CACHE_SIZE ; ++i)
+    {
+        entries[i].decoded.count = 0;
+        entries[i].code = NULL;
+        entries[i].hits = 0;
+    }
+
+    //never writable and executable at once, see protect()
+#ifdef Q_OS_WIN
+    code = (quint8*) VirtualAlloc(NULL, JIT_CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    code = (quint8*) mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(code == MAP_FAILED) code = NULL;
+#endif
+
+    if(!code) std::cerr << "JIT : no code cache, blocks will be interpreted" << std::endl;
+
+    code_used = 0;
+    out = NULL;
+
+    //"qmake CONFIG+=jit_compare"
+#ifdef GB_JIT_COMPARE
+    compare_mode = true;
+#else
+    compare_mode = false;
+#endif
+    reference = NULL;
+}
+
+/* Run the block at PC, compiled if it is hot, interpreted otherwise.
+ * Blocks end on jumps, calls, returns, HALT, STOP, DI and EI, so the caller gets back
+ * control at every point interrupts can be taken.
+ *
+ * Returns the number of cycles elapsed, or 0 if PC is not in cacheable memory or the block
+ * does not fit in the given cycles, in which case the caller steps opcode by opcode.
+ */
+quint32 jit::run(cpu* c, quint32 cycles)
+{
+    entry* e = &entries[c->PC & (JIT_CACHE_SIZE - 1)];
+    const quint32* writes = c->memory.page_writes(c->PC);
+
+    if(!e->decoded.count || e->decoded.address != c->PC || e->decoded.writes != *writes)
+    {
+        if(!c->decode_block(&e->decoded)) return 0;
+
+        e->code = NULL;
+        e->hits = 0;
+    }
+
+    if(e->decoded.cycles > cycles) return 0;
+
+    if(!e->code && ++e->hits >= JIT_HOT_THRESHOLD)
+        e->code = compile(c, &e->decoded);
+
+    if(compare_mode) return run_compare(c, e, writes);
+
+    if(e->code) return e->code(c);
+
+    return c->execute_block(&e->decoded, writes);
+}
+
+/* In compare mode, every block is run by the interpreter first, then undone and run again
+ * by the jit (or the block interpreter if it is not compiled yet). Any difference in the
+ * registers, the cycles or the bytes written is reported and stops the emulator.
+ * Built with GB_JIT_COMPARE (qmake CONFIG+=jit_compare), the jit starts in compare mode.
+ */
+void jit::set_compare_mode(bool enabled)
+{
+    compare_mode = enabled;
+}
+
+
+/////////////////////////////////////
+// CODE GENERATION
+/////////////////////////////////////
+
+/* The generated code is a function quint32 block(cpu* c), which keeps c in rbx and returns
+ * the cycles elapsed. Opcodes only moving registers are translated to native moves on the
+ * cpu fields ; the other ones call jit::execute() with their table entry and operand.
+ *
+ * After a call which may have written into the block's page, the writes counter of the page
+ * is checked, and the block returns early if it changed (self-modifying code).
+ *
+ * The pages the block is generated into are writable meanwhile, and executable again once it is.
+ */
+jit::compiled_block jit::compile(cpu* c, const cpu::block* b)
+{
+    if(!code) return NULL;
+
+    if(code_used + JIT_MAX_BLOCK_CODE > JIT_CODE_SIZE) flush();
+
+    if(!protect(code + code_used, true)) return NULL;
+
+    const quint8* base = (const quint8*) c;
+
+    reg8_offsets[0] = (const quint8*) &c->BC.bytes.high - base;
+    reg8_offsets[1] = (const quint8*) &c->BC.bytes.low - base;
+    reg8_offsets[2] = (const quint8*) &c->DE.bytes.high - base;
+    reg8_offsets[3] = (const quint8*) &c->DE.bytes.low - base;
+    reg8_offsets[4] = (const quint8*) &c->HL.bytes.high - base;
+    reg8_offsets[5] = (const quint8*) &c->HL.bytes.low - base;
+    reg8_offsets[6] = 0;
+    reg8_offsets[7] = (const quint8*) &c->AF.bytes.high - base;
+
+    reg16_offsets[0] = (const quint8*) &c->BC.word - base;
+    reg16_offsets[1] = (const quint8*) &c->DE.word - base;
+    reg16_offsets[2] = (const quint8*) &c->HL.word - base;
+    reg16_offsets[3] = (const quint8*) &c->SP - base;
+
+    pc_offset = (const quint8*) &c->PC - base;
+
+    quint8* start = code + code_used;
+    out = start;
+
+    //push rbx ; sub rsp, 32 (keeps the stack aligned, and is the shadow space on windows)
+    emit8(0x53);
+    emit8(0x48); emit8(0x83); emit8(0xEC); emit8(0x20);
+
+    //mov rbx, <first argument>
+    emit8(0x48); emit8(0x89);
+#ifdef Q_OS_WIN
+    emit8(0xCB);
+#else
+    emit8(0xFB);
+#endif
+
+    const quint32* writes = c->memory.page_writes(b->address);
+    quint16 pc = b->address;
+    quint32 cycles = 0;
+    bool native = false;
+
+    for(quint8 i = 0 ; i < b->count ; ++i)
+    {
+        const cpu::decoded_opcode& d = b->opcodes[i];
+
+        //0xCB opcodes and superinstructions always go through their handler
+        native = d.op == &cpu::opcodes_table[d.code] && compile_native(d.code, d.operand);
+
+        if(!native)
+        {
+            //mov word [rbx + PC], pc
+            emit8(0x66); emit8(0xC7); emit_rbx_operand(0, pc_offset); emit16(pc);
+
+            //execute(c, op, operand)
+#ifdef Q_OS_WIN
+            emit8(0x48); emit8(0x89); emit8(0xD9);                  // mov rcx, rbx
+            emit8(0x48); emit8(0xBA); emit64((quintptr) d.op);      // mov rdx, op
+            emit8(0x41); emit8(0xB8); emit32(d.operand);            // mov r8d, operand
+#else
+            emit8(0x48); emit8(0x89); emit8(0xDF);                  // mov rdi, rbx
+            emit8(0x48); emit8(0xBE); emit64((quintptr) d.op);      // mov rsi, op
+            emit8(0xBA); emit32(d.operand);                         // mov edx, operand
+#endif
+            emit8(0x48); emit8(0xB8); emit64((quintptr) &jit::execute); // mov rax, execute
+            emit8(0xFF); emit8(0xD0);                               // call rax
+
+            if(i + 1 == b->count)
+            {
+                //eax holds the cycles of the last opcode (which may be a conditional one)
+                emit8(0x05); emit32(cycles);                        // add eax, cycles
+                emit_epilogue();
+            }
+            else
+            {
+                emit8(0x48); emit8(0xB9); emit64((quintptr) writes);    // mov rcx, writes
+                emit8(0x81); emit8(0x39); emit32(b->writes);            // cmp dword [rcx], b->writes
+                emit8(0x74); emit8(11);                                 // je over the early return
+                emit8(0xB8); emit32(cycles + d.op->cycles);             // mov eax, cycles
+                emit_epilogue();
+            }
+        }
+
+        cycles += d.op->cycles;
+        pc += d.op->length;
+    }
+
+    if(native)
+    {
+        emit8(0x66); emit8(0xC7); emit_rbx_operand(0, pc_offset); emit16(pc);   // mov word [rbx + PC], pc
+        emit8(0xB8); emit32(cycles);                                            // mov eax, cycles
+        emit_epilogue();
+    }
+
+    code_used += out - start;
+
+    if(!protect(start, false)) return NULL;
+
+    return (compiled_block) start;
+}
+
+/* Translate the opcodes which only move registers : NOP, LD r, r', LD r, d8, LD rr, d16,
+ * INC rr, DEC rr and LD SP, HL.
+ *
+ * Returns false if the opcode has no native translation.
+ */
+bool jit::compile_native(quint8 opcode, quint16 operand)
+{
+    //NOP
+    if(opcode == 0x00) return true;
+
+    //LD r, r'
+    if(opcode >= 0x40 && opcode <= 0x7F && opcode != 0x76)
+    {
+        quint8 dst = (opcode >> 3) & 0x7;
+        quint8 src = opcode & 0x7;
+
+        if(dst == 6 || src == 6) return false;
+
+        if(dst != src)
+        {
+            emit8(0x0F); emit8(0xB6); emit_rbx_operand(0, reg8_offsets[src]);  // movzx eax, byte [src]
+            emit8(0x88); emit_rbx_operand(0, reg8_offsets[dst]);                // mov byte [dst], al
+        }
+
+        return true;
+    }
+
+    //LD r, d8
+    if(opcode < 0x40 && (opcode & 0xC7) == 0x06)
+    {
+        quint8 dst = (opcode >> 3) & 0x7;
+
+        if(dst == 6) return false;
+
+        emit8(0xC6); emit_rbx_operand(0, reg8_offsets[dst]); emit8(operand);   // mov byte [dst], d8
+
+        return true;
+    }
+
+    //LD rr, d16
+    if((opcode & 0xCF) == 0x01)
+    {
+        emit8(0x66); emit8(0xC7); emit_rbx_operand(0, reg16_offsets[opcode >> 4]); emit16(operand);   // mov word [rr], d16
+        return true;
+    }
+
+    //INC rr
+    if((opcode & 0xCF) == 0x03)
+    {
+        emit8(0x66); emit8(0xFF); emit_rbx_operand(0, reg16_offsets[opcode >> 4]);   // inc word [rr]
+        return true;
+    }
+
+    //DEC rr
+    if((opcode & 0xCF) == 0x0B)
+    {
+        emit8(0x66); emit8(0xFF); emit_rbx_operand(1, reg16_offsets[opcode >> 4]);   // dec word [rr]
+        return true;
+    }
+
+    //LD SP, HL
+    if(opcode == 0xF9)
+    {
+        emit8(0x0F); emit8(0xB7); emit_rbx_operand(0, reg16_offsets[2]);               // movzx eax, word [HL]
+        emit8(0x66); emit8(0x89); emit_rbx_operand(0, reg16_offsets[3]);               // mov word [SP], ax
+        return true;
+    }
+
+    return false;
+}
+
+/* Make the pages of the code cache a block is generated into (JIT_MAX_BLOCK_CODE bytes from start)
+ * writable, or executable. Returns false if the protection could not be changed.
+ */
+bool jit::protect(quint8* start, bool writable)
+{
+    quintptr first = (quintptr) start & ~(quintptr) (JIT_PAGE_SIZE - 1);
+    quintptr end = ((quintptr) start + JIT_MAX_BLOCK_CODE + JIT_PAGE_SIZE - 1) & ~(quintptr) (JIT_PAGE_SIZE - 1);
+
+    if(end > (quintptr) code + JIT_CODE_SIZE) end = (quintptr) code + JIT_CODE_SIZE;
+
+#ifdef Q_OS_WIN
+    DWORD previous;
+    bool done = VirtualProtect((void*) first, end - first, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &previous);
+#else
+    bool done = mprotect((void*) first, end - first, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#endif
+
+    if(!done) std::cerr << "JIT : cannot change the protection of the code cache" << std::endl;
+
+    return done;
+}
+
+/* Drop all the generated code, when the code cache is full */
+void jit::flush()
+{
+    code_used = 0;
+
+    for(quint16 i = 0 ; i < JIT_CACHE_SIZE ; ++i)
+        entries[i].code = NULL;
+}
+
+void jit::emit8(quint8 byte)
+{
+    *out++ = byte;
+}
+
+void jit::emit16(quint16 word)
+{
+    emit8(word & 0xFF);
+    emit8(word >> 8);
+}
+
+void jit::emit32(quint32 dword)
+{
+    emit16(dword & 0xFFFF);
+    emit16(dword >> 16);
+}
+
+void jit::emit64(quint64 qword)
+{
+    emit32(qword & 0xFFFFFFFF);
+    emit32(qword >> 32);
+}
+
+/* ModRM and displacement of a [rbx + offset] operand, reg being the register or the opcode extension */
+void jit::emit_rbx_operand(quint8 reg, qint32 offset)
+{
+    emit8(0x83 | (reg << 3));
+    emit32(offset);
+}
+
+/* add rsp, 32 ; pop rbx ; ret */
+void jit::emit_epilogue()
+{
+    emit8(0x48); emit8(0x83); emit8(0xC4); emit8(0x20);
+    emit8(0x5B);
+    emit8(0xC3);
+}
+
+/* Execute one opcode with its handler, as cpu::step_instruction() does.
+ * Returns the number of cycles it took.
+ */
+quint32 jit::execute(cpu* c, const cpu::opcode* op, quint32 operand)
+{
+    c->last_opcode_not_executed = false;
+    c->current_opcode = op;
+    c->operand = operand;
+
+    (c->*(op->exec))();
+
+    c->PC += op->length;
+
+    return c->last_opcode_not_executed ? op->not_exec_cycles : op->cycles;
+}
+
+
+/////////////////////////////////////
+// COMPARE MODE
+/////////////////////////////////////
+
+static void print_state(const char* name, cpu* c, quint16 a, quint16 bc, quint16 de, quint16 hl, quint16 sp, quint16 pc, quint32 cycles)
+{
+    std::cerr << name << std::hex
+              << " A " << a << " F " << (quint16) c->get_f()
+              << " BC " << bc << " DE " << de << " HL " << hl
+              << " SP " << sp << " PC " << pc
+              << std::dec << " cycles " << cycles << std::endl;
+}
+
+/* Copy the registers and the cpu state a block can change */
+void jit::copy_state(cpu* to, const cpu* from)
+{
+    to->AF = from->AF;
+    to->BC = from->BC;
+    to->DE = from->DE;
+    to->HL = from->HL;
+    to->SP = from->SP;
+    to->PC = from->PC;
+    to->flags_op = from->flags_op;
+    to->flags_val1 = from->flags_val1;
+    to->flags_val2 = from->flags_val2;
+    to->flags_carry = from->flags_carry;
+    to->IME = from->IME;
+    to->HALT = from->HALT;
+    to->STOP = from->STOP;
+}
+
+quint32 jit::run_compare(cpu* c, entry* e, const quint32* writes)
+{
+    if(!reference) reference = new cpu();
+
+    //interpreter first, from the same state
+    copy_state(reference, c);
+
+    c->memory.begin_journal();
+
+    quint32 expected = 0;
+
+    for(quint8 i = 0 ; i < e->decoded.count ; ++i)
+    {
+        expected += reference->step_instruction();
+
+        //a superinstruction is two opcodes for the interpreter
+        if(cpu::is_fused(e->decoded.opcodes[i].op)) expected += reference->step_instruction();
+
+        if(*writes != e->decoded.writes && i + 1 < e->decoded.count) break;
+    }
+
+    //a vram dma wrote more than the journal holds : it cannot be undone, so the interpreter run stands
+    if(!c->memory.journal_complete())
+    {
+        c->memory.end_journal();
+        copy_state(c, reference);
+
+        return expected;
+    }
+
+    //a block writes at most 2 bytes per opcode, dma aside
+    quint16 written = qMin<quint16>(c->memory.journal_size(), cpu::BLOCK_MAX_OPCODES * 2);
+    quint16 addresses[cpu::BLOCK_MAX_OPCODES * 2];
+    quint8 values[cpu::BLOCK_MAX_OPCODES * 2];
+
+    for(quint16 i = 0 ; i < written ; ++i)
+    {
+        addresses[i] = c->memory.journal_address(i);
+        values[i] = c->memory.rb(addresses[i]);
+    }
+
+    c->memory.rollback_journal();
+
+    //then the jit
+    quint32 elapsed = e->code ? e->code(c) : c->execute_block(&e->decoded, writes);
+
+    bool same = elapsed == expected
+            && c->get_f() == reference->get_f()
+            && c->AF.bytes.high == reference->AF.bytes.high
+            && c->BC.word == reference->BC.word
+            && c->DE.word == reference->DE.word
+            && c->HL.word == reference->HL.word
+            && c->SP == reference->SP
+            && c->PC == reference->PC
+            && c->IME == reference->IME
+            && c->HALT == reference->HALT
+            && c->STOP == reference->STOP;
+
+    for(quint16 i = 0 ; i < written ; ++i)
+    {
+        if(c->memory.rb(addresses[i]) != values[i])
+        {
+            std::cerr << "JIT : byte at " << std::hex << addresses[i] << " is " << (quint16) c->memory.rb(addresses[i])
+                      << " instead of " << (quint16) values[i] << std::dec << std::endl;
+            same = false;
+        }
+    }
+
+    if(!same)
+    {
+        std::cerr << "JIT : mismatch in block at " << std::hex << e->decoded.address << std::dec
+                  << (e->code ? " (compiled)" : " (interpreted)") << std::endl;
+        print_state("interpreter", reference, reference->AF.bytes.high, reference->BC.word, reference->DE.word, reference->HL.word, reference->SP, reference->PC, expected);
+        print_state("jit        ", c, c->AF.bytes.high, c->BC.word, c->DE.word, c->HL.word, c->SP, c->PC, elapsed);
+        exit(EXIT_FAILURE);
+    }
+
+    return elapsed;
+}
+
+#endif // GB_JIT
@@ -0,0 +1,91 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <Qt>
+
+#include <Utils.h>
+
+#include "cpu.h"
+
+#define _JIT (gb::jit::getInstance())
+
+namespace gb
+{
+
+/* x86-64 backend of the cpu, used by cpu::run_for() when built with GB_JIT.
+ *
+ * Blocks are decoded by the cpu (see cpu::decode_block()) and run by the interpreter until
+ * they are hot, then translated to x86-64 code in an executable code cache. The interpreter
+ * stays the reference : opcodes without a native translation call their handler from the
+ * generated code, and the compare mode runs every block with both and checks they agree.
+ */
+class jit : public utils::patterns::Singleton<jit>
+{
+    friend class utils::patterns::Singleton<jit>;
+
+    enum JIT_CACHE
+    {
+        JIT_CACHE_SIZE          = 1024,             // number of blocks, indexed by the low bits of their address
+        JIT_CODE_SIZE           = 0x400000,         // bytes of executable memory
+        JIT_MAX_BLOCK_CODE      = 0x1000,           // upper bound of the code generated for one block
+        JIT_HOT_THRESHOLD       = 16,               // runs of a block by the interpreter before it is compiled
+        JIT_PAGE_SIZE           = 0x1000            // host pages, the unit of the code cache protection
+    };
+
+    typedef quint32 (*compiled_block)(cpu* c);
+
+    struct entry
+    {
+        cpu::block      decoded;
+        compiled_block  code;                       // NULL until the block is hot
+        quint32         hits;
+    };
+
+    jit();
+
+public:
+
+    quint32 run(cpu* c, quint32 cycles);
+
+    void set_compare_mode(bool enabled);
+
+private:
+
+    entry                       entries[JIT_CACHE_SIZE]                 ;
+
+    quint8*                     code                                    ; //code cache, NULL if it could not be allocated
+    quint32                     code_used                               ;
+    quint8*                     out                                     ; //where the code is being generated
+
+    bool                        compare_mode                            ;
+    cpu*                        reference                               ; //interpreter running each block again in compare mode
+
+    //offsets of the cpu registers, for [rbx + offset] operands
+    qint32                      reg8_offsets[8]                         ; //B, C, D, E, H, L, -, A (opcodes encoding)
+    qint32                      reg16_offsets[4]                        ; //BC, DE, HL, SP
+    qint32                      pc_offset                               ;
+
+    //code generation
+    compiled_block compile(cpu* c, const cpu::block* b);
+    bool compile_native(quint8 opcode, quint16 operand);
+    void flush();
+    bool protect(quint8* start, bool writable);
+
+    void emit8(quint8 byte);
+    void emit16(quint16 word);
+    void emit32(quint32 dword);
+    void emit64(quint64 qword);
+    void emit_rbx_operand(quint8 reg, qint32 offset);
+    void emit_epilogue();
+
+    //called by the generated code
+    static quint32 execute(cpu* c, const cpu::opcode* op, quint32 operand);
+
+    //compare mode
+    quint32 run_compare(cpu* c, entry* e, const quint32* writes);
+    static void copy_state(cpu* to, const cpu* from);
+};
+
+}
+
+#endif // JIT_H
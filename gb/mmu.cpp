@@ -1,74 +1,412 @@
 #include "mmu.h"
 
+#include <QFile>
+
+#include <ctime>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 using namespace gb;
 
 mmu::mmu()
 {
     memset(BIOS, 0, BIOS_SIZE);
     memset(ROM, 0, ROM_SIZE);
-    memset(ERAM, 0, ERAM_SIZE);
-    memset(WRAM, 0, WRAM_SIZE);
+    memset(ERAM, 0, ERAM_MAX_SIZE);
+    memset(VRAM, 0, sizeof(VRAM));
+    memset(WRAM, 0, sizeof(WRAM));
+    memset(OAM, 0, OAM_SIZE);
+    memset(IO, 0, IO_SIZE);
     memset(ZRAM, 0, ZRAM_SIZE);
+    memset(writes, 0, sizeof(writes));
+    total_writes = 0;
+    handler_reads = 0;
+
+    //without cartridge, the rom is the ROM array and the 8 KiB of eram are always enabled
+    cartridge = NULL;
+    rom = ROM;
+    rom_banks_count = ROM_SIZE / ROM_BANK_SIZE;
+    eram = ERAM;
+    eram_banks_count = 1;
+    reset_mbc(MBC_NONE);
+
+    battery = NULL;
+    battery_size = 0;
+    has_battery = false;
+    memset(battery_dirty, 0, sizeof(battery_dirty));
+    tracked_bank = NULL;
+
+    rom_banks[0] = NULL;
+    rom_banks[1] = NULL;
+    eram_bank = NULL;
+    fetch_page = NULL;
+    fetch_page_address = NO_PAGE;
 
     in_bios = true;
+    model = MODEL_DMG;
+
+    //until a peripheral maps them, io registers are plain memory
+    for(quint8 i = 0 ; i < IO_SIZE ; ++i)
+    {
+        io_registers[i].read = read_io_plain;
+        io_registers[i].write = write_io_plain;
+        io_registers[i].read_device = this;
+        io_registers[i].write_device = this;
+        io_registers[i].read_mask = io_read_masks[i];
+    }
+
+    map_io(OAM_DMA, NULL, write_oam_dma, this);
+    map_io(VBK, NULL, write_vbk, this);
+    map_io(BOOT_ROM_DISABLE, NULL, write_boot_rom_disable, this);
+    map_io(HDMA5, read_hdma5, write_hdma5, this);
+    map_io(SVBK, NULL, write_svbk, this);
+
+    dma_source = 0;
+    dma_cycles = 0;
+
+    memset(&cgb, 0, sizeof(cgb));
+    cgb.wram_bank = 1;
+
+    select_banks();
+    map_pages();
+
+#ifdef GB_JIT
+    journaling = false;
+    journal_overflow = false;
+    journal_count = 0;
+#endif
 }
 
-quint8  mmu::rb(quint16 address)
+/* Point the pages tables to the host memory of every page which can be accessed directly,
+ * the other pages are left NULL and go through read_special() and write_special().
+ * Called again whenever the whole memory map changes, bank switching only remaps its window.
+ */
+void    mmu::map_pages()
 {
-    //rom 0
-    if(address >= ROM0_START && address <= ROM0_END)
+    for(quint16 page = 0 ; page < 0x100 ; ++page)
     {
-        if(in_bios)
+        quint16 address = page << 8;
+        quint8* memory = NULL;
+
+        //wram bank 0 & its shadow
+        if((address >= WRAM_START && address < WRAM_START + WRAM_BANK_SIZE)
+                || (address >= WRAM_SHADOW_START && address < WRAM_SHADOW_START + WRAM_BANK_SIZE))
+        {
+            memory = &WRAM[address & (WRAM_BANK_SIZE - 1)];
+        }
+
+        read_pages[page] = memory;
+        write_pages[page] = memory;
+    }
+
+    map_rom(0);
+    map_rom(1);
+    map_vram();
+    map_eram();
+    map_wram();
+}
+
+/* Map the current bank of the given rom window (0 : 0x0000 - 0x3FFF, 1 : 0x4000 - 0x7FFF).
+ * Rom is never written : writes go to the bank controller through write_special().
+ * Until the bios is switched off, it overlays the first page of rom 0.
+ */
+void    mmu::map_rom(quint8 window)
+{
+    quint16 start = window ? ROM1_START : ROM0_START;
+
+    for(quint16 offset = 0 ; offset < ROM_BANK_SIZE ; offset += 0x100)
+    {
+        quint8 page = (start + offset) >> 8;
+
+        read_pages[page] = (page == (BIOS_START >> 8) && in_bios) ? BIOS : &rom_banks[window][offset];
+        write_pages[page] = NULL;
+
+        //code decoded from the former bank is stale
+        writes[page]++;
+    }
+
+    total_writes++;
+    fetch_page_address = NO_PAGE;
+}
+
+/* Map the current vram bank. Nothing in the lcd locks vram yet, so it is plain memory. */
+void    mmu::map_vram()
+{
+    vram_bank = &VRAM[cgb.vram_bank * VRAM_SIZE];
+
+    for(quint16 offset = 0 ; offset < VRAM_SIZE ; offset += 0x100)
+    {
+        quint8 page = (VRAM_START + offset) >> 8;
+
+        read_pages[page] = &vram_bank[offset];
+        write_pages[page] = &vram_bank[offset];
+
+        writes[page]++;
+    }
+
+    total_writes++;
+    fetch_page_address = NO_PAGE;
+}
+
+/* Map the current wram bank at 0xD000 - 0xDFFF and in its shadow (0xF000 - 0xFDFF) */
+void    mmu::map_wram()
+{
+    wram_bank = &WRAM[cgb.wram_bank * WRAM_BANK_SIZE];
+
+    for(quint16 offset = 0 ; offset < WRAM_BANK_SIZE ; offset += 0x100)
+    {
+        quint8 page = (WRAM_START + WRAM_BANK_SIZE + offset) >> 8;
+        quint8 shadow = (WRAM_SHADOW_START + WRAM_BANK_SIZE + offset) >> 8;
+
+        read_pages[page] = &wram_bank[offset];
+        write_pages[page] = &wram_bank[offset];
+
+        if(shadow <= (WRAM_SHADOW_END >> 8))
         {
-            if(address <= BIOS_END)
-                return BIOS[address];
-            else
-                in_bios = false;
+            read_pages[shadow] = &wram_bank[offset];
+            write_pages[shadow] = &wram_bank[offset];
         }
 
-        return ROM[address];
+        //shared with the shadow
+        writes[page]++;
     }
 
-    //rom 1
-    else if(address >= ROM1_START && address <= ROM1_END)
+    total_writes++;
+    fetch_page_address = NO_PAGE;
+}
+
+/* Map the current eram bank, or leave the window to read_special() and write_special()
+ * when the ram is disabled or is not plain memory (MBC2 half-bytes, MBC3 clock).
+ */
+void    mmu::map_eram()
+{
+    //the writes into the former bank are battery changes
+    mark_eram_dirty();
+
+    for(quint16 offset = 0 ; offset < ERAM_BANK_SIZE ; offset += 0x100)
     {
-        return ROM[address];
+        quint8 page = (ERAM_START + offset) >> 8;
+
+        read_pages[page] = eram_bank ? &eram_bank[offset] : NULL;
+        write_pages[page] = eram_bank ? &eram_bank[offset] : NULL;
+
+        writes[page]++;
+        tracked_writes[offset >> 8] = writes[page];
     }
 
-    //vram
-    else if(address >= VRAM_START && address <= VRAM_END)
+    total_writes++;
+    fetch_page_address = NO_PAGE;
+}
+
+/* Map the rom file at the given path read-only, its banks being used in place : nothing is copied
+ * and the pages are shared with any other process mapping the same file. Until a cartridge is
+ * loaded, the ROM array is used.
+ *
+ * The bank controller and the eram size are read from the cartridge header.
+ *
+ * Returns false, keeping the current rom, if the file cannot be mapped or is not a rom.
+ */
+bool    mmu::load_cartridge(const QString& path)
+{
+    QFile* file = new QFile(path);
+
+    if(!file->open(QIODevice::ReadOnly))
     {
-        // return gpu vram here
+        std::cerr << "MMU : cannot open " << path.toStdString() << std::endl;
+        delete file;
+        return false;
     }
 
-    //eram
-    else if(address >= ERAM_START && address <= ERAM_END)
+    qint64 size = file->size();
+
+    if(size < 2 * ROM_BANK_SIZE || size > CARTRIDGE_MAX_SIZE || size % ROM_BANK_SIZE)
     {
-        return ERAM[address & 0x1FFF];
+        std::cerr << "MMU : " << path.toStdString() << " is not a rom (" << size << " bytes)" << std::endl;
+        delete file;
+        return false;
     }
 
-    //wram
-    else if(address >= WRAM_START && address <= WRAM_END)
+    const quint8* data = file->map(0, size);
+
+    if(!data)
     {
-        return WRAM[address & 0x1FFF];
+        std::cerr << "MMU : cannot map " << path.toStdString() << std::endl;
+        delete file;
+        return false;
     }
 
-    //wram shadow
-    else if(address >= WRAM_SHADOW_START && address <= WRAM_SHADOW_END)
+    quint8 type = MBC_NONE;
+    quint8 cartridge_type = data[CARTRIDGE_TYPE];
+
+    switch(cartridge_type)
     {
-        return WRAM[address & 0x1FFF];
+    case 0x00: case 0x08: case 0x09:
+        type = MBC_NONE;
+        break;
+    case 0x01: case 0x02: case 0x03:
+        type = MBC_1;
+        break;
+    case 0x05: case 0x06:
+        type = MBC_2;
+        break;
+    case 0x0F: case 0x10: case 0x11: case 0x12: case 0x13:
+        type = MBC_3;
+        break;
+    case 0x19: case 0x1A: case 0x1B: case 0x1C: case 0x1D: case 0x1E:
+        type = MBC_5;
+        break;
+    default:
+        std::cerr << "MMU : unsupported cartridge type 0x" << std::hex << (int) data[CARTRIDGE_TYPE] << std::dec
+                  << ", running it as rom only" << std::endl;
+        break;
+    }
+
+    //banks of 8 KiB (2 KiB carts get a whole bank), MBC2 ram is built in the controller
+    static const quint8 eram_banks[6] = {0, 1, 1, 4, 16, 8};
+    quint8 eram_size = data[CARTRIDGE_ERAM_SIZE];
+
+    //the battery file of the former cartridge is written back and unmapped, until load_battery() the eram is ERAM
+    close_battery();
+
+    //the QFile keeps the mapping alive, and unmaps it when deleted
+    delete cartridge;
+
+    cartridge = file;
+    rom = data;
+    rom_banks_count = size / ROM_BANK_SIZE;
+    eram_banks_count = (type == MBC_2) ? 1 : (eram_size < 6 ? eram_banks[eram_size] : 0);
+    reset_mbc(type);
+
+    has_battery = cartridge_type == 0x03 || cartridge_type == 0x06 || cartridge_type == 0x09 || cartridge_type == 0x0F
+               || cartridge_type == 0x10 || cartridge_type == 0x13 || cartridge_type == 0x1B || cartridge_type == 0x1E;
+    memset(battery_dirty, 0, sizeof(battery_dirty));
+    tracked_bank = NULL;
+
+    eram = ERAM;
+    memset(ERAM, 0, ERAM_MAX_SIZE);
+
+    select_banks();
+    map_pages();
+
+    return true;
+}
+
+/* Values of the io registers when the bios of each model hands over to the cartridge
+ * (Pan Docs, power up sequence). Registers the hardware leaves undefined are not listed.
+ */
+const mmu::post_boot_register mmu::post_boot_registers[] =
+{
+    //address   DMG   MGB   CGB
+    {0xFF00, {0xCF, 0xCF, 0xC7}},   // P1
+    {0xFF01, {0x00, 0x00, 0x00}},   // SB
+    {0xFF02, {0x7E, 0x7E, 0x7F}},   // SC
+    {0xFF04, {0xAB, 0xAB, 0x00}},   // DIV
+    {0xFF05, {0x00, 0x00, 0x00}},   // TIMA
+    {0xFF06, {0x00, 0x00, 0x00}},   // TMA
+    {0xFF07, {0xF8, 0xF8, 0xF8}},   // TAC
+    {0xFF0F, {0xE1, 0xE1, 0xE1}},   // IF
+    {0xFF10, {0x80, 0x80, 0x80}},   // NR10
+    {0xFF11, {0xBF, 0xBF, 0xBF}},   // NR11
+    {0xFF12, {0xF3, 0xF3, 0xF3}},   // NR12
+    {0xFF13, {0xFF, 0xFF, 0xFF}},   // NR13
+    {0xFF14, {0xBF, 0xBF, 0xBF}},   // NR14
+    {0xFF16, {0x3F, 0x3F, 0x3F}},   // NR21
+    {0xFF17, {0x00, 0x00, 0x00}},   // NR22
+    {0xFF18, {0xFF, 0xFF, 0xFF}},   // NR23
+    {0xFF19, {0xBF, 0xBF, 0xBF}},   // NR24
+    {0xFF1A, {0x7F, 0x7F, 0x7F}},   // NR30
+    {0xFF1B, {0xFF, 0xFF, 0xFF}},   // NR31
+    {0xFF1C, {0x9F, 0x9F, 0x9F}},   // NR32
+    {0xFF1D, {0xFF, 0xFF, 0xFF}},   // NR33
+    {0xFF1E, {0xBF, 0xBF, 0xBF}},   // NR34
+    {0xFF20, {0xFF, 0xFF, 0xFF}},   // NR41
+    {0xFF21, {0x00, 0x00, 0x00}},   // NR42
+    {0xFF22, {0x00, 0x00, 0x00}},   // NR43
+    {0xFF23, {0xBF, 0xBF, 0xBF}},   // NR44
+    {0xFF24, {0x77, 0x77, 0x77}},   // NR50
+    {0xFF25, {0xF3, 0xF3, 0xF3}},   // NR51
+    {0xFF26, {0xF1, 0xF1, 0xF1}},   // NR52
+    {0xFF40, {0x91, 0x91, 0x91}},   // LCDC
+    {0xFF41, {0x85, 0x85, 0x85}},   // STAT
+    {0xFF42, {0x00, 0x00, 0x00}},   // SCY
+    {0xFF43, {0x00, 0x00, 0x00}},   // SCX
+    {0xFF44, {0x00, 0x00, 0x00}},   // LY
+    {0xFF45, {0x00, 0x00, 0x00}},   // LYC
+    {0xFF46, {0xFF, 0xFF, 0x00}},   // DMA
+    {0xFF47, {0xFC, 0xFC, 0xFC}},   // BGP
+    {0xFF4A, {0x00, 0x00, 0x00}},   // WY
+    {0xFF4B, {0x00, 0x00, 0x00}},   // WX
+    {0xFF4D, {0xFF, 0xFF, 0x7E}},   // KEY1
+    {0xFF4F, {0xFF, 0xFF, 0xFE}},   // VBK
+    {0xFF50, {0xFF, 0xFF, 0xFF}},   // BOOT_ROM_DISABLE
+    {0xFF51, {0xFF, 0xFF, 0xFF}},   // HDMA1
+    {0xFF52, {0xFF, 0xFF, 0xFF}},   // HDMA2
+    {0xFF53, {0xFF, 0xFF, 0xFF}},   // HDMA3
+    {0xFF54, {0xFF, 0xFF, 0xFF}},   // HDMA4
+    {0xFF55, {0xFF, 0xFF, 0xFF}},   // HDMA5
+    {0xFF56, {0xFF, 0xFF, 0x3E}},   // RP
+    {0xFF70, {0xFF, 0xFF, 0xF8}},   // SVBK
+    {0xFFFF, {0x00, 0x00, 0x00}}    // IE
+};
+
+/* Skip the bios : the io registers get the values the bios of the given model leaves, and the bios
+ * is switched off. The cpu side is cpu::fast_boot().
+ */
+void    mmu::fast_boot(MODEL model)
+{
+    set_model(model);
+
+    for(quint8 i = 0 ; i < sizeof(post_boot_registers) / sizeof(post_boot_register) ; ++i)
+    {
+        const post_boot_register& reg = post_boot_registers[i];
+
+        //through the handlers, so that the peripherals get them
+        if(reg.address >= ZRAM_START)
+            ZRAM[reg.address - ZRAM_START] = reg.values[model];
+        else
+            write_io(reg.address, reg.values[model]);
+    }
+
+    //the values of DMA and HDMA5 are not transfers the bios started
+    dma_cycles = 0;
+    cgb.hdma_active = false;
+    cgb.hdma_blocks = 0;
+    cgb.hdma_stall = 0;
+
+    if(in_bios) unmap_bios();
+}
+
+/* A write to BOOT_ROM_DISABLE switches the bios off : rom 0 takes its page back */
+void    mmu::unmap_bios()
+{
+    in_bios = false;
+
+    map_rom(0);
+}
+
+quint8  mmu::read_special(quint16 address)
+{
+    //eram, when not plain memory
+    if(address >= ERAM_START && address <= ERAM_END)
+    {
+        return read_eram(address);
     }
 
     //oam
     else if(address >= OAM_START && address <= OAM_END)
     {
-        // return gpu oam here
+        return dma_cycles ? 0xFF : OAM[address - OAM_START];
     }
 
     //io
     else if(address >= IO_START && address <= IO_END)
     {
-        //io management here
+        return read_io(address);
     }
 
     //zram
@@ -80,81 +418,824 @@ quint8  mmu::rb(quint16 address)
     return 0;
 }
 
-quint16 mmu::rw(quint16 address)
+void    mmu::write_special(quint16 address, quint8 byte)
+{
+    //rom : bank controller. No memory changes, so the rom pages counters are left as they are
+    //(and the code decoded from them) unless a bank switch remaps a window, see map_rom()
+    if(address >= ROM0_START && address <= ROM1_END)
+    {
+        write_mbc(address, byte);
+        return;
+    }
+
+    writes[writes_page(address)]++;
+    total_writes++;
+
+    //eram, when not plain memory
+    if(address >= ERAM_START && address <= ERAM_END)
+    {
+        write_eram(address, byte);
+    }
+
+    //oam
+    else if(address >= OAM_START && address <= OAM_END)
+    {
+        if(!dma_cycles) OAM[address - OAM_START] = byte;
+    }
+
+    //io
+    else if(address >= IO_START && address <= IO_END)
+    {
+        write_io(address, byte);
+    }
+
+    //zram
+    else if(address >= ZRAM_START && address <= ZRAM_END)
+    {
+        ZRAM[address & 0x7F] = byte;
+    }
+}
+
+/////////////////////////////////////
+// IO REGISTERS
+/////////////////////////////////////
+
+/* Bits of each io register which read as 1 : unused bits, write-only registers and
+ * unmapped addresses (DMG registers, Pan Docs)
+ */
+const quint8 mmu::io_read_masks[IO_SIZE] =
+{
+    //0x0   0x1   0x2   0x3   0x4   0x5   0x6   0x7   0x8   0x9   0xA   0xB   0xC   0xD   0xE   0xF
+    0xC0, 0x00, 0x7E, 0xFF, 0x00, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xE0, // 0xFF00 joypad, serial, timer, IF
+    0x80, 0x3F, 0x00, 0xFF, 0xBF, 0xFF, 0x3F, 0x00, 0xFF, 0xBF, 0x7F, 0xFF, 0x9F, 0xFF, 0xBF, 0xFF, // 0xFF10 sound
+    0xFF, 0xFF, 0x00, 0x00, 0xBF, 0x00, 0x00, 0x70, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xFF20 sound
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0xFF30 wave pattern
+    0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, // 0xFF40 lcd
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xFF50 boot rom
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xFF60
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF  // 0xFF70
+};
+
+/* Registers the CGB adds or changes : offset from IO_START, bits which read as 1 */
+const quint8 mmu::cgb_io_read_masks[][2] =
+{
+    {0x02, 0x7C},   // SC
+    {0x4D, 0x7E},   // KEY1
+    {0x4F, 0xFE},   // VBK
+    {0x55, 0x00},   // HDMA5
+    {0x56, 0x3C},   // RP
+    {0x68, 0x40},   // BCPS
+    {0x69, 0x00},   // BCPD
+    {0x6A, 0x40},   // OCPS
+    {0x6B, 0x00},   // OCPD
+    {0x70, 0xF8}    // SVBK
+};
+
+/* Select the hardware emulated, which changes the io registers available */
+void    mmu::set_model(MODEL model)
+{
+    Q_ASSERT(model < MODEL_COUNT);
+
+    this->model = model;
+
+    //the DMG has only the first banks
+    cgb.vram_bank = 0;
+    cgb.wram_bank = 1;
+    cgb.hdma_active = false;
+    map_vram();
+    map_wram();
+
+    for(quint8 i = 0 ; i < IO_SIZE ; ++i)
+        io_registers[i].read_mask = io_read_masks[i];
+
+    if(model != MODEL_CGB) return;
+
+    for(quint8 i = 0 ; i < sizeof(cgb_io_read_masks) / sizeof(cgb_io_read_masks[0]) ; ++i)
+        io_registers[cgb_io_read_masks[i][0]].read_mask = cgb_io_read_masks[i][1];
+}
+
+/* Give the io register at address to a peripheral : its reads and writes call the given handlers
+ * with device, so the peripheral only has to catch up (timer, lcd...) when its own registers are
+ * accessed. A NULL handler leaves that direction to the plain IO array.
+ */
+void    mmu::map_io(quint16 address, io_read_func read, io_write_func write, void* device)
+{
+    io_register& reg = io_registers[address - IO_START];
+
+    reg.read = read ? read : read_io_plain;
+    reg.read_device = read ? device : this;
+    reg.write = write ? write : write_io_plain;
+    reg.write_device = write ? device : this;
+}
+
+inline quint8 mmu::read_io(quint16 address)
+{
+    const io_register& reg = io_registers[address - IO_START];
+
+    if(reg.read != read_io_plain)
+        handler_reads++;
+
+    return reg.read(reg.read_device, address) | reg.read_mask;
+}
+
+inline void mmu::write_io(quint16 address, quint8 byte)
+{
+    const io_register& reg = io_registers[address - IO_START];
+
+    reg.write(reg.write_device, address, byte);
+}
+
+quint8  mmu::read_io_plain(void* device, quint16 address)
+{
+    return ((mmu*) device)->IO[address - IO_START];
+}
+
+void    mmu::write_io_plain(void* device, quint16 address, quint8 byte)
+{
+    ((mmu*) device)->IO[address - IO_START] = byte;
+}
+
+void    mmu::write_boot_rom_disable(void* device, quint16 address, quint8 byte)
+{
+    mmu* m = (mmu*) device;
+
+    m->IO[address - IO_START] = byte;
+
+    if(byte && m->in_bios)
+        m->unmap_bios();
+}
+
+/* Writing OAM_DMA starts a transfer into oam from (byte << 8), restarting the running one if any.
+ * Nothing is copied byte by byte : the whole transfer lands at once when its cycles have elapsed
+ * (see elapse_dma()), which is all the cpu can see of it since oam is unreachable until then.
+ */
+void    mmu::write_oam_dma(void* device, quint16 address, quint8 byte)
+{
+    mmu* m = (mmu*) device;
+
+    m->IO[address - IO_START] = byte;
+
+    m->dma_source = byte << 8;
+    m->dma_cycles = OAM_DMA_CYCLES;
+}
+
+/* Copy the 160 bytes of the oam dma, in one go when the source is plain memory */
+void    mmu::complete_dma()
+{
+    const quint8* source = page(dma_source);
+
+    dma_cycles = 0;
+
+    if(source)
+        memcpy(OAM, source, OAM_DMA_SIZE);
+    else
+    {
+        for(quint8 i = 0 ; i < OAM_DMA_SIZE ; ++i)
+            OAM[i] = rb(dma_source + i);
+    }
+
+    writes[writes_page(OAM_START)]++;
+    total_writes++;
+}
+
+/////////////////////////////////////
+// CGB BANKS & VRAM DMA
+/////////////////////////////////////
+
+/* VBK : bit 0 selects the vram bank (CGB only) */
+void    mmu::write_vbk(void* device, quint16 address, quint8 byte)
+{
+    mmu* m = (mmu*) device;
+
+    m->IO[address - IO_START] = byte;
+
+    if(m->model != MODEL_CGB || m->cgb.vram_bank == (byte & 0x01)) return;
+
+    m->cgb.vram_bank = byte & 0x01;
+    m->map_vram();
+}
+
+/* SVBK : bits 0-2 select the wram bank of 0xD000 - 0xDFFF, 0 selecting bank 1 (CGB only) */
+void    mmu::write_svbk(void* device, quint16 address, quint8 byte)
+{
+    mmu* m = (mmu*) device;
+    quint8 bank = (byte & 0x07) ? (byte & 0x07) : 1;
+
+    m->IO[address - IO_START] = byte;
+
+    if(m->model != MODEL_CGB || m->cgb.wram_bank == bank) return;
+
+    m->cgb.wram_bank = bank;
+    m->map_wram();
+}
+
+/* HDMA5 : blocks left minus one, bit 7 clear while an hblank dma runs (0xFF once it is over) */
+quint8  mmu::read_hdma5(void* device, quint16)
+{
+    const cgb_registers& cgb = ((mmu*) device)->cgb;
+
+    return (cgb.hdma_active ? 0x00 : 0x80) | ((cgb.hdma_blocks - 1) & 0x7F);
+}
+
+/* HDMA5 : starts a copy of ((byte & 0x7F) + 1) blocks of 16 bytes from HDMA1-2 to vram at HDMA3-4.
+ * Bit 7 set : one block at each hblank (see hblank()), the first one a scanline later. Bit 7 clear :
+ * general purpose dma, all the blocks at once, or stops the running hblank dma.
+ */
+void    mmu::write_hdma5(void* device, quint16, quint8 byte)
+{
+    mmu* m = (mmu*) device;
+    cgb_registers& cgb = m->cgb;
+
+    if(m->model != MODEL_CGB) return;
+
+    if(cgb.hdma_active && !(byte & 0x80))
+    {
+        cgb.hdma_active = false;
+        return;
+    }
+
+    cgb.hdma_source = ((m->IO[HDMA1 - IO_START] << 8) | m->IO[HDMA2 - IO_START]) & 0xFFF0;
+    cgb.hdma_destination = ((m->IO[HDMA3 - IO_START] << 8) | m->IO[HDMA4 - IO_START]) & (VRAM_SIZE - HDMA_BLOCK_SIZE);
+    cgb.hdma_blocks = (byte & 0x7F) + 1;
+
+    if(byte & 0x80)
+    {
+        cgb.hdma_active = true;
+        cgb.hdma_line_cycles = 0;
+        return;
+    }
+
+    while(cgb.hdma_blocks)
+        m->copy_hdma_block();
+}
+
+/* Run the next block of the hblank dma, if any */
+void    mmu::hblank()
 {
-    return rb(address) + ( rb(address + 1) << 8);
+    if(cgb.hdma_active)
+        copy_hdma_block();
 }
 
-void    mmu::wb(quint16 address, quint8 byte)
+/* Copy 16 bytes of vram dma into the current vram bank, in one go when the source is plain memory.
+ * The cpu is stalled meanwhile, which elapse_dma() hands over to cpu::run_for().
+ */
+void    mmu::copy_hdma_block()
 {
-    //rom 0
-    if(address >= ROM0_START && address <= ROM0_END)
+    quint16 address = cgb.hdma_source;
+
+    //the source is 0x0000 - 0x7FF0 or 0xA000 - 0xDFF0 : 0xE000 - 0xFFF0 reads 0xA000 - 0xBFF0
+    if(address >= WRAM_SHADOW_START)
+        address -= WRAM_SHADOW_START - ERAM_START;
+
+    const quint8* source = page(address);
+    quint8* destination = &vram_bank[cgb.hdma_destination];
+
+#ifdef GB_JIT
+    if(journaling)
+    {
+        for(quint8 i = 0 ; i < HDMA_BLOCK_SIZE ; ++i)
+            record_write(VRAM_START + cgb.hdma_destination + i);
+    }
+#endif
+
+    //vram is no valid source, the bus reads 0xFF
+    if(address >= VRAM_START && address <= VRAM_END)
+        memset(destination, 0xFF, HDMA_BLOCK_SIZE);
+    else if(source)
+        memcpy(destination, &source[address & 0xFF], HDMA_BLOCK_SIZE);
+    else
     {
-        if(in_bios)
+        for(quint8 i = 0 ; i < HDMA_BLOCK_SIZE ; ++i)
+            destination[i] = rb(address + i);
+    }
+
+    writes[writes_page(VRAM_START + cgb.hdma_destination)]++;
+    total_writes++;
+
+    cgb.hdma_source += HDMA_BLOCK_SIZE;
+    cgb.hdma_destination += HDMA_BLOCK_SIZE;
+    cgb.hdma_stall += HDMA_BLOCK_CYCLES;
+    cgb.hdma_blocks--;
+
+    //the transfer stops at the end of vram
+    if(cgb.hdma_destination >= VRAM_SIZE)
+        cgb.hdma_blocks = 0;
+
+    if(cgb.hdma_blocks == 0)
+        cgb.hdma_active = false;
+}
+
+/* Called when PC left the page of the fetch cache (jump, call, return or just running past its end)
+ * or when the memory map changed. The new page is kept only if it is plain memory, otherwise
+ * (io, zram...) every fetch from it goes through read_special().
+ */
+quint8  mmu::fetch_slow(quint16 address)
+{
+    const quint8* page = read_pages[address >> 8];
+
+    if(!page)
+    {
+        fetch_page_address = NO_PAGE;
+        return read_special(address);
+    }
+
+    fetch_page = page;
+    fetch_page_address = address & PAGE_MASK;
+
+    return page[address & ~PAGE_MASK];
+}
+
+/////////////////////////////////////
+// BANK CONTROLLERS
+/////////////////////////////////////
+
+void    mmu::reset_mbc(quint8 type)
+{
+    memset(&mbc, 0, sizeof(mbc));
+
+    mbc.type = type;
+    mbc.ram_enabled = (type == MBC_NONE);
+    mbc.rom_bank = 1;
+    mbc.latch = 0xFF;
+}
+
+/* Write into the registers of the bank controller (0x0000 - 0x7FFF), then switch banks.
+ * Ignored by rom only cartridges.
+ */
+void    mmu::write_mbc(quint16 address, quint8 byte)
+{
+    switch(mbc.type)
+    {
+    case MBC_1:
+        if(address <= MBC_RAM_ENABLE_END)
+            mbc.ram_enabled = (byte & 0x0F) == MBC_RAM_ENABLED;
+        else if(address <= MBC_ROM_BANK_END)
+            mbc.rom_bank = (byte & 0x1F) ? (byte & 0x1F) : 1;
+        else if(address <= MBC_RAM_BANK_END)
+            mbc.ram_bank = byte & 0x03;
+        else
+            mbc.mode = byte & 0x01;
+        break;
+
+    case MBC_2:
+        if(address > MBC_ROM_BANK_END)
+            return;
+        if(address & MBC2_ROM_BANK_SELECT)
+            mbc.rom_bank = (byte & 0x0F) ? (byte & 0x0F) : 1;
+        else
+            mbc.ram_enabled = (byte & 0x0F) == MBC_RAM_ENABLED;
+        break;
+
+    case MBC_3:
+        if(address <= MBC_RAM_ENABLE_END)
+            mbc.ram_enabled = (byte & 0x0F) == MBC_RAM_ENABLED;
+        else if(address <= MBC_ROM_BANK_END)
+            mbc.rom_bank = (byte & 0x7F) ? (byte & 0x7F) : 1;
+        else if(address <= MBC_RAM_BANK_END)
+            mbc.ram_bank = byte;
+        else
         {
-            if(address <= BIOS_END)
-            {
-                BIOS[address] = byte;
-                return;
-            }
-            else
-                in_bios = false;
+            //writing 0 then 1 latches the clock
+            if(mbc.latch == 0x00 && byte == 0x01)
+                memcpy(mbc.rtc_latched, mbc.rtc, sizeof(mbc.rtc));
+
+            mbc.latch = byte;
+            return;
         }
+        break;
+
+    case MBC_5:
+        if(address <= MBC_RAM_ENABLE_END)
+            mbc.ram_enabled = (byte & 0x0F) == MBC_RAM_ENABLED;
+        else if(address <= MBC5_ROM_BANK_LOW_END)
+            mbc.rom_bank = (mbc.rom_bank & 0x100) | byte;
+        else if(address <= MBC_ROM_BANK_END)
+            mbc.rom_bank = (mbc.rom_bank & 0xFF) | ((byte & 0x01) << 8);
+        else if(address <= MBC_RAM_BANK_END)
+            mbc.ram_bank = byte & 0x0F;
+        else
+            return;
+        break;
+
+    default:
+        return;
+    }
 
-        ROM[address] = byte;
+    select_banks();
+}
+
+/* Point the rom and eram windows to the banks selected by the controller registers.
+ * Switching a bank only swaps the pointers of its window in the pages tables : nothing is copied,
+ * and the windows which did not change are left as they are (along with the code decoded from them).
+ */
+void    mmu::select_banks()
+{
+    quint16 bank0 = 0;
+    quint16 bank1 = mbc.rom_bank;
+    quint8 ram = mbc.ram_bank;
+    bool plain_ram = mbc.ram_enabled && eram_banks_count > 0;
+
+    switch(mbc.type)
+    {
+    case MBC_1:
+        //upper bits : rom bank bits 5-6, and in mode 1 the rom 0 bank and the ram bank as well
+        bank1 |= mbc.ram_bank << 5;
+        if(mbc.mode)
+            bank0 = mbc.ram_bank << 5;
+        else
+            ram = 0;
+        break;
+
+    case MBC_2:
+        plain_ram = false;
+        break;
+
+    case MBC_3:
+        if(ram >= MBC3_RTC_FIRST)
+            plain_ram = false;
+        break;
     }
 
-    //rom 1
-    else if(address >= ROM1_START && address <= ROM1_END)
+    const quint8* rom0 = &rom[(bank0 % rom_banks_count) * ROM_BANK_SIZE];
+    const quint8* rom1 = &rom[(bank1 % rom_banks_count) * ROM_BANK_SIZE];
+    quint8* ram_bank = plain_ram ? &eram[(ram % eram_banks_count) * ERAM_BANK_SIZE] : NULL;
+
+    if(rom0 != rom_banks[0])
     {
-        ROM[address] = byte;
+        rom_banks[0] = rom0;
+        map_rom(0);
     }
 
-    //vram
-    else if(address >= VRAM_START && address <= VRAM_END)
+    if(rom1 != rom_banks[1])
     {
-        // set gpu vram here
+        rom_banks[1] = rom1;
+        map_rom(1);
     }
 
-    //eram
-    else if(address >= ERAM_START && address <= ERAM_END)
+    if(ram_bank != eram_bank)
     {
-        ERAM[address & 0x1FFF] = byte;
+        eram_bank = ram_bank;
+        map_eram();
     }
+}
+
+/* Eram reads which are not plain memory : disabled ram, MBC2 half-bytes, MBC3 clock */
+quint8  mmu::read_eram(quint16 address)
+{
+    if(!mbc.ram_enabled)
+        return 0xFF;
+
+    if(mbc.type == MBC_2)
+        return 0xF0 | eram[address & (MBC2_ERAM_SIZE - 1)];
 
-    //wram
-    else if(address >= WRAM_START && address <= WRAM_END)
+    if(mbc.type == MBC_3 && mbc.ram_bank >= MBC3_RTC_FIRST && mbc.ram_bank <= MBC3_RTC_LAST)
+        return mbc.rtc_latched[mbc.ram_bank - MBC3_RTC_FIRST];
+
+    return 0xFF;
+}
+
+void    mmu::write_eram(quint16 address, quint8 byte)
+{
+    if(!mbc.ram_enabled)
+        return;
+
+    if(mbc.type == MBC_2)
     {
-        WRAM[address & 0x1FFF] = byte;
+        eram[address & (MBC2_ERAM_SIZE - 1)] = byte & 0x0F;
+        battery_dirty[(address & (MBC2_ERAM_SIZE - 1)) >> 8] = true;
     }
 
-    //wram shadow
-    else if(address >= WRAM_SHADOW_START && address <= WRAM_SHADOW_END)
+    else if(mbc.type == MBC_3 && mbc.ram_bank >= MBC3_RTC_FIRST && mbc.ram_bank <= MBC3_RTC_LAST)
+        mbc.rtc[mbc.ram_bank - MBC3_RTC_FIRST] = byte;
+}
+
+/* Bytes of eram the cartridge has (MBC2 : its 512 half-bytes, one per byte) */
+quint32 mmu::eram_size()
+{
+    if(mbc.type == MBC_2)
+        return MBC2_ERAM_SIZE;
+
+    return eram_banks_count * ERAM_BANK_SIZE;
+}
+
+/////////////////////////////////////
+// BATTERY
+/////////////////////////////////////
+
+/* Map the battery file at the given path read-write and use it as the eram of the cartridge : the game
+ * writes straight into the shared mapping, so a crash of the emulator loses nothing, and a crash of the
+ * host system only what was written since the last flush_battery(). A new file gets the current eram.
+ * A file smaller than the eram (and clock) is grown, a larger one is left as it is and only its start is
+ * mapped, so that what other emulators save after the eram is kept.
+ *
+ * Returns false, keeping the current eram, if the cartridge has no battery or the file cannot be mapped.
+ */
+bool    mmu::load_battery(const QString& path)
+{
+    static_assert(sizeof(rtc_save) == RTC_SAVE_SIZE, "rtc_save is not the saved clock layout");
+
+    if(!has_battery)
     {
-        WRAM[address & 0x1FFF] = byte;
+        std::cerr << "MMU : the cartridge has no battery" << std::endl;
+        return false;
     }
 
-    //oam
-    else if(address >= OAM_START && address <= OAM_END)
+    quint32 size = eram_size() + (mbc.type == MBC_3 ? RTC_SAVE_SIZE : 0);
+
+    if(!size)
+        return false;
+
+    QFile* file = new QFile(path);
+
+    if(!file->open(QIODevice::ReadWrite))
     {
-        // set gpu oam here
+        std::cerr << "MMU : cannot open " << path.toStdString() << std::endl;
+        delete file;
+        return false;
     }
 
-    //io
-    else if(address >= IO_START && address <= IO_END)
+    qint64 file_size = file->size();
+
+    if(file_size < size && !file->resize(size))
     {
-        //io management here
+        std::cerr << "MMU : cannot resize " << path.toStdString() << " to " << size << " bytes" << std::endl;
+        delete file;
+        return false;
     }
 
-    //zram
+    quint8* data = file->map(0, size);
+
+    if(!data)
+    {
+        std::cerr << "MMU : cannot map " << path.toStdString() << std::endl;
+        delete file;
+        return false;
+    }
+
+    //the writes into the current bank are forgotten with it
+    tracked_bank = NULL;
+    memset(battery_dirty, 0, sizeof(battery_dirty));
+
+    if(file_size == 0)
+    {
+        memcpy(data, eram, eram_size());
+        memset(battery_dirty, true, (size + 0xFF) >> 8);
+    }
+    else if(mbc.type == MBC_3 && file_size >= size)
+    {
+        const rtc_save* clock = (const rtc_save*) &data[eram_size()];
+
+        for(quint8 i = 0 ; i < 5 ; ++i)
+        {
+            mbc.rtc[i] = clock->registers[i];
+            mbc.rtc_latched[i] = clock->latched[i];
+        }
+    }
+
+    close_battery();
+
+    battery_lock.lock();
+    battery = file;
+    battery_size = size;
+    eram = data;
+    battery_lock.unlock();
+
+    //remap the eram window into the file
+    eram_bank = NULL;
+    select_banks();
+
+    return true;
+}
+
+/* Called on the emulation thread (once per frame for instance) : fills ranges with the parts of the battery
+ * file changed since the last call, and returns their count. Only counters are compared, so it never stalls
+ * a frame ; the ranges are then written to disk by flush_battery(), from any thread.
+ * If there are more than max_ranges of them, the last one covers the rest.
+ */
+quint16 mmu::battery_changes(battery_range* ranges, quint16 max_ranges)
+{
+    if(!battery || !max_ranges)
+        return 0;
+
+    mark_eram_dirty();
+
+    if(mbc.type == MBC_3)
+        save_rtc();
+
+    quint16 count = 0;
+
+    for(quint32 offset = 0 ; offset < battery_size ; offset += 0x100)
+    {
+        if(!battery_dirty[offset >> 8])
+            continue;
+
+        battery_dirty[offset >> 8] = false;
+
+        quint32 size = qMin<quint32>(0x100, battery_size - offset);
+
+        if(count && ranges[count - 1].offset + ranges[count - 1].size == offset)
+            ranges[count - 1].size += size;
+        else if(count < max_ranges)
+        {
+            ranges[count].offset = offset;
+            ranges[count].size = size;
+            count++;
+        }
+        else
+            ranges[count - 1].size = offset + size - ranges[count - 1].offset;
+    }
+
+    return count;
+}
+
+/* Write a range returned by battery_changes() back to the battery file, waiting for the disk.
+ * Meant to be called from a thread of the host : loading a cartridge or a battery file waits for it,
+ * and a range of a file unmapped meanwhile is flushed in the new one, or not at all.
+ */
+bool    mmu::flush_battery(const battery_range& range)
+{
+    QMutexLocker lock(&battery_lock);
+
+    if(!battery || range.offset + range.size > battery_size)
+        return false;
+
+    return sync_battery(range.offset, range.size);
+}
+
+/* Write bytes of the battery mapping back to the file, waiting for the disk. battery_lock must be held. */
+bool    mmu::sync_battery(quint32 offset, quint32 size)
+{
+#ifdef Q_OS_WIN
+    return FlushViewOfFile(eram + offset, size);
+#else
+    //msync() wants the start of a page of the host
+    quintptr page_size = sysconf(_SC_PAGESIZE);
+    quintptr start = (quintptr) (eram + offset) & ~(page_size - 1);
+    quintptr end = (quintptr) (eram + offset + size);
+
+    return msync((void*) start, end - start, MS_SYNC) == 0;
+#endif
+}
+
+/* Write the whole battery file back and unmap it, the eram being ERAM again */
+void    mmu::close_battery()
+{
+    QMutexLocker lock(&battery_lock);
+
+    if(!battery)
+        return;
+
+    if(!sync_battery(0, battery_size))
+        std::cerr << "MMU : cannot write the battery file back" << std::endl;
+
+    delete battery;
+
+    battery = NULL;
+    battery_size = 0;
+    eram = ERAM;
+}
+
+/* The eram window is plain memory, so its writes are not seen one by one : the writes counters of its pages
+ * are compared to what they were when the bank was mapped or last checked, and the pages which changed are
+ * marked dirty in the battery file.
+ */
+void    mmu::mark_eram_dirty()
+{
+    if(tracked_bank)
+    {
+        quint32 first = (tracked_bank - eram) >> 8;
+
+        for(quint8 i = 0 ; i < (ERAM_BANK_SIZE >> 8) ; ++i)
+        {
+            if(writes[(ERAM_START >> 8) + i] != tracked_writes[i])
+                battery_dirty[first + i] = true;
+        }
+    }
+
+    tracked_bank = eram_bank;
+
+    for(quint8 i = 0 ; i < (ERAM_BANK_SIZE >> 8) ; ++i)
+        tracked_writes[i] = writes[(ERAM_START >> 8) + i];
+}
+
+/* Copy the MBC3 clock to the battery file if it changed */
+void    mmu::save_rtc()
+{
+    rtc_save* clock = (rtc_save*) &eram[eram_size()];
+    bool changed = false;
+
+    for(quint8 i = 0 ; i < 5 ; ++i)
+    {
+        if(clock->registers[i] != mbc.rtc[i] || clock->latched[i] != mbc.rtc_latched[i])
+        {
+            clock->registers[i] = mbc.rtc[i];
+            clock->latched[i] = mbc.rtc_latched[i];
+            changed = true;
+        }
+    }
+
+    if(!changed)
+        return;
+
+    clock->timestamp = time(NULL);
+
+    //the eram is whole banks, so the clock fits in one page
+    battery_dirty[eram_size() >> 8] = true;
+}
+
+#ifdef GB_JIT
+
+/* Start recording the writes (and the value they overwrite) */
+void    mmu::begin_journal()
+{
+    journaling = true;
+    journal_overflow = false;
+    journal_count = 0;
+    journal_in_bios = in_bios;
+    journal_mbc = mbc;
+    journal_dma_source = dma_source;
+    journal_dma_cycles = dma_cycles;
+    journal_cgb = cgb;
+    memcpy(journal_writes, writes, sizeof(writes));
+    journal_total_writes = total_writes;
+}
+
+/* Record the host memory a write is about to change. Writes to the bank controller registers
+ * change no memory, they are undone by restoring the registers.
+ */
+void    mmu::record_write(quint16 address)
+{
+    if(journal_count >= JOURNAL_SIZE)
+    {
+        journal_overflow = true;
+        return;
+    }
+
+    quint8* location = write_pages[address >> 8];
+
+    if(location)
+        location += address & 0xFF;
+    else if(address >= OAM_START && address <= OAM_END && !dma_cycles)
+        location = &OAM[address - OAM_START];
+    else if(address >= IO_START && address <= IO_END)
+        location = &IO[address - IO_START];
     else if(address >= ZRAM_START && address <= ZRAM_END)
+        location = &ZRAM[address & 0x7F];
+    else if(mbc.type == MBC_2 && mbc.ram_enabled && address >= ERAM_START && address <= ERAM_END)
+        location = &eram[address & (MBC2_ERAM_SIZE - 1)];
+
+    journal[journal_count].address = address;
+    journal[journal_count].location = location;
+    journal[journal_count].byte = location ? *location : 0;
+    journal_count++;
+}
+
+/* Undo the writes recorded since begin_journal(), writes counters and banks included, and stop recording */
+void    mmu::rollback_journal()
+{
+    journaling = false;
+
+    while(journal_count > 0)
     {
-        ZRAM[address & 0x7F] = byte;
+        journal_count--;
+
+        if(journal[journal_count].location)
+            *journal[journal_count].location = journal[journal_count].byte;
     }
+
+    in_bios = journal_in_bios;
+    mbc = journal_mbc;
+    dma_source = journal_dma_source;
+    dma_cycles = journal_dma_cycles;
+    cgb = journal_cgb;
+    select_banks();
+    map_pages();
+
+    memcpy(writes, journal_writes, sizeof(writes));
+    total_writes = journal_total_writes;
+}
+
+/* Stop recording and keep the writes, for when the journal could not hold them all */
+void    mmu::end_journal()
+{
+    journaling = false;
+    journal_count = 0;
 }
 
-void    mmu::ww(quint16 address, quint16 word)
+/* False if some writes did not fit in the journal (vram dma), so that a rollback would be incomplete */
+bool    mmu::journal_complete()
 {
-    wb(address, word & 0x0F);
-    wb(address + 1, word & 0xF0);
+    return !journal_overflow;
 }
+
+quint16 mmu::journal_size()
+{
+    return journal_count;
+}
+
+quint16 mmu::journal_address(quint16 index)
+{
+    return journal[index].address;
+}
+
+#endif // GB_JIT
@@ -3,6 +3,11 @@
 
 #include <Utils.h>
 #include <Qt>
+#include <QtGlobal>
+#include <QString>
+#include <QMutex>
+
+class QFile;
 
 #define _MMU (gb::mmu::getInstance())
 
@@ -53,38 +58,526 @@ public:
         ZRAM_END = 0xFFFF
     };
 
+    enum MODEL
+    {
+        MODEL_DMG = 0,                  // Game Boy
+        MODEL_MGB = 1,                  // Game Boy Pocket
+        MODEL_CGB = 2,                  // Game Boy Color
+        MODEL_COUNT
+    };
+
+    enum IO_REGISTERS
+    {
+        OAM_DMA = 0xFF46,               // writing XX copies XX00 - XX9F into oam
+        VBK = 0xFF4F,                   // CGB vram bank
+        BOOT_ROM_DISABLE = 0xFF50,      // any non zero write unmaps the bios
+        HDMA1 = 0xFF51,                 // CGB vram dma source, high
+        HDMA2 = 0xFF52,                 // source, low
+        HDMA3 = 0xFF53,                 // destination, high
+        HDMA4 = 0xFF54,                 // destination, low
+        HDMA5 = 0xFF55,                 // length / mode / start
+        SVBK = 0xFF70                   // CGB wram bank of 0xD000 - 0xDFFF
+    };
+
+    enum CGB_MEMORY
+    {
+        VRAM_BANKS = 2,
+        WRAM_BANKS = 8,
+        WRAM_BANK_SIZE = 0x1000,
+        HDMA_BLOCK_SIZE = 0x10,
+        HDMA_BLOCK_CYCLES = 32,         // cpu cycles stalled by each block
+        HBLANK_PERIOD = 456             // cpu cycles of a scanline, which ends with one hblank
+    };
+
+    enum DMA
+    {
+        OAM_DMA_SIZE = 0xA0,
+        OAM_DMA_CYCLES = 640            // 160 us, during which the cpu can only reach hram
+    };
+
     enum MEMORY_SIZE
     {
-        BIOS_SIZE = BIOS_END - BIOS_START,
-        ROM0_SIZE = ROM0_END - ROM0_START,
-        ROM1_SIZE = ROM1_END - ROM1_START,
+        BIOS_SIZE = BIOS_END - BIOS_START + 1,
+        ROM0_SIZE = ROM0_END - ROM0_START + 1,
+        ROM1_SIZE = ROM1_END - ROM1_START + 1,
         ROM_SIZE  = ROM0_SIZE + ROM1_SIZE,
-        VRAM_SIZE = VRAM_END - VRAM_START,
-        ERAM_SIZE = ERAM_END - ERAM_START,
-        WRAM_SIZE = WRAM_END - WRAM_START,
-        OAM_SIZE = OAM_END - OAM_START,
-        IO_SIZE = IO_END - IO_START,
-        ZRAM_SIZE = ZRAM_END - ZRAM_START
+        VRAM_SIZE = VRAM_END - VRAM_START + 1,
+        ERAM_SIZE = ERAM_END - ERAM_START + 1,
+        WRAM_SIZE = WRAM_END - WRAM_START + 1,
+        OAM_SIZE = OAM_END - OAM_START + 1,
+        IO_SIZE = IO_END - IO_START + 1,
+        ZRAM_SIZE = ZRAM_END - ZRAM_START + 1
     };
 
+    enum CARTRIDGE
+    {
+        ROM_BANK_SIZE = 0x4000,
+        ERAM_BANK_SIZE = 0x2000,
+        CARTRIDGE_MAX_SIZE = 0x800000,  // 8 MiB, 512 banks
+        ERAM_MAX_SIZE = 0x20000,        // 128 KiB, 16 banks
+        //cartridge header
+        CARTRIDGE_TYPE = 0x0147,
+        CARTRIDGE_ERAM_SIZE = 0x0149
+    };
+
+    enum MBC_TYPE
+    {
+        MBC_NONE = 0,                   // rom only (or no cartridge)
+        MBC_1 = 1,
+        MBC_2 = 2,
+        MBC_3 = 3,
+        MBC_5 = 5
+    };
+
+    enum BATTERY
+    {
+        RTC_SAVE_SIZE = 48,             // MBC3 clock, saved after the eram (see rtc_save)
+        BATTERY_PAGES = (ERAM_MAX_SIZE + RTC_SAVE_SIZE + 0xFF) >> 8
+    };
+
+    //part of the battery file, in bytes
+    struct battery_range
+    {
+        quint32 offset;
+        quint32 size;
+    };
+
+    enum PAGES
+    {
+        PAGE_MASK = 0xFF00,
+        NO_PAGE = 0x0001                // never the address of a page
+    };
+
+    //io register handlers of a peripheral, called with the device given to map_io()
+    typedef quint8 (*io_read_func)(void* device, quint16 address);
+    typedef void (*io_write_func)(void* device, quint16 address, quint8 byte);
+
     mmu();
 
+    bool    load_cartridge(const QString& path);
+    void    map_io(quint16 address, io_read_func read, io_write_func write, void* device);
+    void    set_model(MODEL model);
+    void    fast_boot(MODEL model);
+
+    //battery-backed eram
+    bool    load_battery(const QString& path);
+    quint16 battery_changes(battery_range* ranges, quint16 max_ranges);
+    bool    flush_battery(const battery_range& range);
+
     quint8  rb(quint16 address);
+    quint8  fetch(quint16 address);
     quint16 rw(quint16 address);
     void    wb(quint16 address, quint8 byte);
     void    ww(quint16 address, quint16 word);
 
+    const quint8* page(quint16 address);
+    const quint32* page_writes(quint16 address);
+    quint32 writes_count();
+    quint32 handler_reads_count();
+
+    //oam dma and vram dma stalls, driven by cpu::run_for()
+    bool    dma_active();
+    quint16 dma_cycles_left();
+    quint32 elapse_dma(quint32 cycles);
+
+    //one block of the running hblank dma, run by elapse_dma() every scanline until there is an lcd
+    void    hblank();
+
+#ifdef GB_JIT
+    //journal of the writes, so that the jit compare mode can undo what the reference interpreter did
+    void    begin_journal();
+    void    rollback_journal();
+    void    end_journal();
+    bool    journal_complete();
+    quint16 journal_size();
+    quint16 journal_address(quint16 index);
+#endif
+
 private:
 
     quint8 BIOS[BIOS_SIZE]      ;
     quint8 ROM[ROM_SIZE]        ;
-    quint8 ERAM[ERAM_SIZE]      ;
-    quint8 WRAM[WRAM_SIZE]      ;
+    quint8 ERAM[ERAM_MAX_SIZE]  ; //eram of the cartridges without battery file
+    quint8 VRAM[VRAM_BANKS * VRAM_SIZE];
+    quint8 WRAM[WRAM_BANKS * WRAM_BANK_SIZE]; //bank 0, then the banks of 0xD000 - 0xDFFF (only bank 1 on DMG)
+    quint8 OAM[OAM_SIZE]        ;
+    quint8 IO[IO_SIZE]          ; //io registers without a peripheral behind them
     quint8 ZRAM[ZRAM_SIZE]      ;
 
     bool in_bios                ;
+    quint8 model                ; //MODEL
+
+    QFile* cartridge            ; //rom file mapped read-only, NULL if none is loaded
+    const quint8* rom           ; //the whole rom : the cartridge mapping, or ROM
+    quint16 rom_banks_count     ;
+    quint8* eram                ; //all the banks of the cartridge ram : ERAM, or the battery file mapping
+    quint8 eram_banks_count     ;
+
+    //battery
+    QFile* battery              ; //battery file mapped read-write, NULL if none is loaded
+    quint32 battery_size        ; //bytes of the mapping : eram, then the MBC3 clock
+    bool has_battery            ;
+    QMutex battery_lock         ; //held by flush_battery() and while the battery file is mapped or unmapped
+
+    //battery changes, by 256-bytes pages of the battery file
+    bool battery_dirty[BATTERY_PAGES];
+    quint8* tracked_bank        ; //eram bank whose writes are counted by the eram window pages counters
+    quint32 tracked_writes[ERAM_BANK_SIZE >> 8]; //counters of these pages when the bank was last tracked
+
+    //values of the io registers the bios leaves
+    struct post_boot_register
+    {
+        quint16 address;
+        quint8 values[MODEL_COUNT];
+    };
+
+    static const post_boot_register post_boot_registers[];
+
+    //io registers dispatch, indexed by address - IO_START
+    struct io_register
+    {
+        io_read_func read;
+        io_write_func write;
+        void* read_device;          // the mmu for the plain handlers
+        void* write_device;
+        quint8 read_mask;           // bits which read as 1 (unused or write-only)
+    };
+
+    io_register io_registers[IO_SIZE];
+    static const quint8 io_read_masks[IO_SIZE];
+    static const quint8 cgb_io_read_masks[][2];
+
+    quint8  read_io(quint16 address);
+    void    write_io(quint16 address, quint8 byte);
+    static quint8 read_io_plain(void* device, quint16 address);
+    static void write_io_plain(void* device, quint16 address, quint8 byte);
+    static void write_boot_rom_disable(void* device, quint16 address, quint8 byte);
+
+    //oam dma
+    quint16 dma_source          ;
+    quint16 dma_cycles          ; //cycles left before the transfer lands in oam, 0 if none is running
+
+    static void write_oam_dma(void* device, quint16 address, quint8 byte);
+    void    complete_dma();
+
+    //CGB banks and vram dma
+    struct cgb_registers
+    {
+        quint8 vram_bank;
+        quint8 wram_bank;           // bank of 0xD000 - 0xDFFF, never 0
+        quint16 hdma_source;
+        quint16 hdma_destination;   // offset in vram
+        quint8 hdma_blocks;         // blocks of 16 bytes left
+        bool hdma_active;           // hblank dma running
+        quint32 hdma_line_cycles;   // cycles since the last hblank of the running hblank dma
+        quint32 hdma_stall;         // cpu cycles the copies stalled it, not yet accounted by elapse_dma()
+    };
+
+    cgb_registers cgb           ;
+    quint8* vram_bank           ; //host memory of the 0x8000 - 0x9FFF window
+    quint8* wram_bank           ; //host memory of the 0xD000 - 0xDFFF window
+
+    void    map_vram();
+    void    map_wram();
+    void    copy_hdma_block();
+
+    static void write_vbk(void* device, quint16 address, quint8 byte);
+    static void write_svbk(void* device, quint16 address, quint8 byte);
+    static quint8 read_hdma5(void* device, quint16 address);
+    static void write_hdma5(void* device, quint16 address, quint8 byte);
+
+    //memory bank controller
+    enum MBC_REGISTERS
+    {
+        MBC_RAM_ENABLE_END = 0x1FFF,    // 0x0000 - 0x1FFF : ram enable
+        MBC5_ROM_BANK_LOW_END = 0x2FFF, // 0x2000 - 0x2FFF : MBC5 8 lower bits of the rom bank, 0x3000 - 0x3FFF : its 9th bit
+        MBC_ROM_BANK_END = 0x3FFF,      // 0x2000 - 0x3FFF : rom bank
+        MBC_RAM_BANK_END = 0x5FFF,      // 0x4000 - 0x5FFF : ram bank, MBC1 upper rom bank bits, MBC3 clock register
+                                        // 0x6000 - 0x7FFF : MBC1 banking mode, MBC3 clock latch
+        MBC_RAM_ENABLED = 0x0A,         // low nibble enabling the ram
+        MBC2_ROM_BANK_SELECT = 0x0100,  // MBC2 address bit choosing the rom bank register over ram enable
+        MBC2_ERAM_SIZE = 0x0200,        // 512 half-bytes built in the controller
+        MBC3_RTC_FIRST = 0x08,
+        MBC3_RTC_LAST = 0x0C
+    };
+
+    struct mbc_registers
+    {
+        quint8 type;                // MBC_TYPE
+        bool ram_enabled;
+        quint16 rom_bank;           // bank of the 0x4000 - 0x7FFF window (its 5 lower bits for MBC1)
+        quint8 ram_bank;            // ram bank, MBC1 upper rom bank bits, MBC3 clock register
+        bool mode;                  // MBC1 banking mode
+        quint8 latch;               // MBC3 last byte written to the latch register
+        quint8 rtc[5];              // MBC3 clock : seconds, minutes, hours, days (low), days (high) & flags
+        quint8 rtc_latched[5];
+    };
+
+    mbc_registers mbc           ;
+
+    //MBC3 clock as saved after the eram, in the layout most emulators share
+    struct rtc_save
+    {
+        quint32 registers[5];
+        quint32 latched[5];
+        qint64 timestamp;           // unix time of the save
+    };
+    const quint8* rom_banks[2]  ; //host memory of the 0x0000 - 0x3FFF and 0x4000 - 0x7FFF windows
+    quint8* eram_bank           ; //host memory of the 0xA000 - 0xBFFF window, NULL if disabled or not plain memory
+
+    //fetch cache : the page opcodes were last fetched from, reset whenever the memory map changes
+    const quint8* fetch_page    ;
+    quint16 fetch_page_address  ; //NO_PAGE if none
+
+    quint32 writes[0x100]       ; //writes counter of each 256-bytes page
+    quint32 total_writes        ; //writes counter of the whole memory, memory map changes included
+    quint32 handler_reads       ; //reads of io registers given to a peripheral handler, see handler_reads_count()
+
+    //memory map : host memory of each 256-bytes page, NULL for the pages handled by read_special() and write_special()
+    const quint8* read_pages[0x100];
+    quint8* write_pages[0x100]  ;
+
+    static quint8 writes_page(quint16 address);
+
+    //slow path of rb(), wb() and fetch(), kept out of line so that the fast path stays small enough to be inlined
+    void    map_pages();
+    void    map_rom(quint8 window);
+    void    map_eram();
+    void    unmap_bios();
+    [[gnu::noinline]] quint8  read_special(quint16 address);
+    [[gnu::noinline]] void    write_special(quint16 address, quint8 byte);
+    [[gnu::noinline]] quint8  fetch_slow(quint16 address);
+
+    //bank controllers
+    void    reset_mbc(quint8 type);
+    void    write_mbc(quint16 address, quint8 byte);
+    void    select_banks();
+    quint8  read_eram(quint16 address);
+    void    write_eram(quint16 address, quint8 byte);
+    quint32 eram_size();
+
+    //battery
+    void    mark_eram_dirty();
+    void    save_rtc();
+    bool    sync_battery(quint32 offset, quint32 size);
+    void    close_battery();
+
+#ifdef GB_JIT
+    enum JOURNAL
+    {
+        JOURNAL_SIZE = 256          // opcodes write at most 2 bytes each, but a vram dma up to 2048 : see journal_complete()
+    };
+
+    struct journal_entry
+    {
+        quint16 address;
+        quint8* location;           // host memory written, NULL if none (bank controller, vram...)
+        quint8 byte;                // value before the write
+    };
+
+    bool journaling             ;
+    bool journal_overflow       ; //writes were dropped, the journal cannot be rolled back
+    quint16 journal_count       ;
+    journal_entry journal[JOURNAL_SIZE];
+    quint32 journal_writes[0x100];
+    quint32 journal_total_writes;
+    bool journal_in_bios        ;
+    mbc_registers journal_mbc   ;
+    quint16 journal_dma_source  ;
+    quint16 journal_dma_cycles  ;
+    cgb_registers journal_cgb   ;
+
+    void    record_write(quint16 address);
+#endif
 };
 
+/////////////////////////////////////
+// FAST PATH
+/////////////////////////////////////
+
+/* Index of the writes counter of the page containing address.
+ * The wram shadow is the same memory as the wram, so they share their counters.
+ */
+inline quint8 mmu::writes_page(quint16 address)
+{
+    if(address >= WRAM_SHADOW_START && address <= WRAM_SHADOW_END)
+        address -= WRAM_SHADOW_START - WRAM_START;
+
+    return address >> 8;
+}
+
+/* Read a byte. Pages of plain memory are read directly through the read pages table,
+ * the other ones (vram, oam, io, zram) by read_special().
+ */
+inline quint8 mmu::rb(quint16 address)
+{
+    const quint8* page = read_pages[address >> 8];
+
+    if(page) return page[address & 0xFF];
+
+    return read_special(address);
+}
+
+inline void mmu::wb(quint16 address, quint8 byte)
+{
+#ifdef GB_JIT
+    if(journaling) record_write(address);
+#endif
+
+    quint8* page = write_pages[address >> 8];
+
+    if(page)
+    {
+        writes[writes_page(address)]++;
+        total_writes++;
+
+        page[address & 0xFF] = byte;
+        return;
+    }
+
+    write_special(address, byte);
+}
+
+/* Read a little-endian word. When both bytes are in the same page of plain memory, they are read from
+ * the page at once (compilers merge the two loads into one unaligned 16-bit load), otherwise (page
+ * boundary, io...) byte by byte through rb().
+ */
+inline quint16 mmu::rw(quint16 address)
+{
+    const quint8* page = read_pages[address >> 8];
+    quint8 offset = address & 0xFF;
+
+    if(page && offset != 0xFF)
+    {
+        const quint8* bytes = &page[offset];
+        return bytes[0] | (bytes[1] << 8);
+    }
+
+    return rb(address) | (rb(address + 1) << 8);
+}
+
+inline void mmu::ww(quint16 address, quint16 word)
+{
+    quint8* page = write_pages[address >> 8];
+    quint8 offset = address & 0xFF;
+
+    if(page && offset != 0xFF)
+    {
+        writes[writes_page(address)] += 2;
+        total_writes += 2;
+
+#ifdef GB_JIT
+        if(journaling)
+        {
+            record_write(address);
+            record_write(address + 1);
+        }
+#endif
+
+        quint8* bytes = &page[offset];
+        bytes[0] = word & 0xFF;
+        bytes[1] = word >> 8;
+        return;
+    }
+
+    wb(address, word & 0xFF);
+    wb(address + 1, word >> 8);
+}
+
+/* Read a byte of the instruction stream. The page opcodes are fetched from is kept, so that as long
+ * as PC stays in it, fetching does not even look the pages table up.
+ */
+inline quint8 mmu::fetch(quint16 address)
+{
+    if((address & PAGE_MASK) == fetch_page_address)
+        return fetch_page[address & ~PAGE_MASK];
+
+    return fetch_slow(address);
+}
+
+/* Host memory of the 256-bytes page containing address, if the whole page can be read
+ * directly with the same result as rb() : no side effect and nothing emulated behind it.
+ * Returns NULL otherwise (vram, oam, io...).
+ */
+inline const quint8* mmu::page(quint16 address)
+{
+    return read_pages[address >> 8];
+}
+
+/* Counter of the writes into the 256-bytes page containing address.
+ * Code decoded from a page stays valid as long as its counter has not changed.
+ */
+inline const quint32* mmu::page_writes(quint16 address)
+{
+    return &writes[writes_page(address)];
+}
+
+/* Counter of all the writes, bumped as well when the memory map changes (bios switched off, bank switching).
+ * Memory is unchanged as long as it has not changed.
+ */
+inline quint32 mmu::writes_count()
+{
+    return total_writes;
+}
+
+/* Counter of the reads of io registers mapped to a peripheral handler (LY, DIV, STAT...).
+ * Their value may change without any write, as time goes by.
+ */
+inline quint32 mmu::handler_reads_count()
+{
+    return handler_reads;
+}
+
+/* An oam dma is running (oam reads 0xFF and ignores writes until it is over),
+ * an hblank dma is running, or vram dma copies stalled the cpu
+ */
+inline bool mmu::dma_active()
+{
+    return dma_cycles != 0 || cgb.hdma_active || cgb.hdma_stall != 0;
+}
+
+/* Cycles before the next dma event : the running oam dma landing in oam, or the next block of the
+ * running hblank dma. 0 if neither is running.
+ */
+inline quint16 mmu::dma_cycles_left()
+{
+    quint16 cycles = dma_cycles;
+
+    if(cgb.hdma_active && (!cycles || HBLANK_PERIOD - cgb.hdma_line_cycles < cycles))
+        cycles = HBLANK_PERIOD - cgb.hdma_line_cycles;
+
+    return cycles;
+}
+
+/* Let cycles of the running oam dma elapse, the transfer landing in oam once they all did,
+ * and copy a block of the running hblank dma every HBLANK_PERIOD cycles.
+ * Returns the cycles vram dma copies stalled the cpu since the last call.
+ */
+inline quint32 mmu::elapse_dma(quint32 cycles)
+{
+    if(cgb.hdma_active)
+    {
+        cgb.hdma_line_cycles += cycles;
+
+        while(cgb.hdma_active && cgb.hdma_line_cycles >= HBLANK_PERIOD)
+        {
+            cgb.hdma_line_cycles -= HBLANK_PERIOD;
+            hblank();
+        }
+    }
+
+    quint32 stall = cgb.hdma_stall;
+
+    cgb.hdma_stall = 0;
+
+    if(cycles < dma_cycles)
+        dma_cycles -= cycles;
+    else if(dma_cycles)
+        complete_dma();
+
+    return stall;
+}
+
 }
 
 #endif // MMU_H